@@ -138,7 +138,9 @@ include(NifSkope_targets.pri)
 INCLUDEPATH += src lib
 
 HEADERS += \
+	src/data/niffield.h \
 	src/data/nifitem.h \
+	src/data/nifitempool.h \
 	src/data/niftypes.h \
 	src/data/nifvalue.h \
 	src/gl/marker/constraints.h \
@@ -195,6 +197,8 @@ HEADERS += \
 	src/ui/settingsdialog.h \
 	src/ui/settingspane.h \
 	src/xml/nifexpr.h \
+	src/xml/schemacache.h \
+	src/benchmark.h \
 	src/glview.h \
 	src/message.h \
 	src/nifskope.h \
@@ -205,6 +209,8 @@ HEADERS += \
 	lib/half.h
 
 SOURCES += \
+	src/data/niffield.cpp \
+	src/data/nifitempool.cpp \
 	src/data/niftypes.cpp \
 	src/data/nifvalue.cpp \
 	src/gl/bsshape.cpp \
@@ -278,6 +284,8 @@ SOURCES += \
 	src/xml/kfmxml.cpp \
 	src/xml/nifexpr.cpp \
 	src/xml/nifxml.cpp \
+	src/xml/schemacache.cpp \
+	src/benchmark.cpp \
 	src/glview.cpp \
 	src/main.cpp \
 	src/message.cpp \
@@ -36,12 +36,22 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "lz4frame.h"
 
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
 #include <QStringBuilder>
+#include <QThread>
+#include <QThreadPool>
+
+#include <climits>
 
 
 // see bsa.h
@@ -77,26 +87,25 @@ static bool BSAReadSizedString( QFile & bsa, QString & s )
 	return false;
 }
 
-QByteArray gUncompress( const QByteArray & data, const int size )
+//! Inflates zlib data, straight into a buffer of the unpacked size if it is known
+static QByteArray gUncompress( const char * data, const int size, const int unpackedSize = 0 )
 {
-	if ( data.size() <= 4 ) {
+	if ( size <= 4 ) {
 		qWarning( "gUncompress: Input data is truncated" );
 		return QByteArray();
 	}
 
-	QByteArray result;
+	QByteArray result( unpackedSize > 0 ? unpackedSize : 4 * size, Qt::Uninitialized );
 
 	int ret;
 	z_stream strm;
-	static const int CHUNK_SIZE = 1024;
-	char out[CHUNK_SIZE];
 
 	/* allocate inflate state */
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
 	strm.avail_in = size;
-	strm.next_in = (Bytef*)(data.data());
+	strm.next_in = (Bytef*)(data);
 
 	ret = inflateInit2( &strm, 15 + 32 ); // gzip decoding
 	Q_ASSERT( ret == Z_OK );
@@ -104,9 +113,13 @@ QByteArray gUncompress( const QByteArray & data, const int size )
 		return QByteArray();
 
 	// run inflate()
-	do {
-		strm.avail_out = CHUNK_SIZE;
-		strm.next_out = (Bytef*)(out);
+	for ( ;; ) {
+		// Only grown when the unpacked size is unknown or wrong
+		if ( strm.total_out == uLong( result.size() ) )
+			result.resize( result.size() * 2 );
+
+		strm.next_out = (Bytef*)(result.data() + strm.total_out);
+		strm.avail_out = uInt( result.size() - strm.total_out );
 
 		ret = inflate( &strm, Z_NO_FLUSH );
 		Q_ASSERT( ret != Z_STREAM_ERROR );  // state not clobbered
@@ -120,14 +133,68 @@ QByteArray gUncompress( const QByteArray & data, const int size )
 			return QByteArray();
 		}
 
-		result.append( out, CHUNK_SIZE - strm.avail_out );
-	} while ( strm.avail_out == 0 );
+		// Done, or the input ran out before the output did
+		if ( ret == Z_STREAM_END || strm.avail_out > 0 )
+			break;
+	}
+
+	result.resize( int( strm.total_out ) );
 
 	// clean up and return
 	inflateEnd( &strm );
 	return result;
 }
 
+//! Inflates zlib data into a buffer of exactly the unpacked size
+static bool gUncompressInto( const char * data, const int size, char * out, const int unpackedSize )
+{
+	if ( size <= 4 || unpackedSize <= 0 )
+		return false;
+
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.avail_in = size;
+	strm.next_in = (Bytef*)(data);
+
+	if ( inflateInit2( &strm, 15 + 32 ) != Z_OK ) // gzip decoding
+		return false;
+
+	strm.next_out = (Bytef*)(out);
+	strm.avail_out = uInt( unpackedSize );
+
+	int ret = inflate( &strm, Z_FINISH );
+	bool ok = ret == Z_STREAM_END && strm.total_out == uLong( unpackedSize );
+
+	inflateEnd( &strm );
+	return ok;
+}
+
+//! Unpacks one chunk of a BA2 texture to its place in the texture
+class TexChunkTask final : public QRunnable
+{
+public:
+	TexChunkTask( const QByteArray & packed, const F4TexChunk & chunk, char * out )
+		: packed( packed ), chunk( chunk ), out( out ) {}
+
+	void run() override
+	{
+		if ( !gUncompressInto( packed.constData(), packed.size(), out, int( chunk.unpackedSize ) ) ) {
+			qCritical() << "Size does not match at " << chunk.offset;
+			memset( out, 0, chunk.unpackedSize );
+		}
+	}
+
+private:
+	QByteArray packed;
+	F4TexChunk chunk;
+	char * out;
+};
+
+//! Textures with less unpacked data than this are unpacked on the calling thread
+static const qint64 ParallelTextureSize = 1 << 20;
+
 // see bsa.h
 BSA::BSA( const QString & filename )
 	: FSArchiveFile(), bsa( filename ), bsaInfo( QFileInfo(filename) ), status( "initialized" )
@@ -179,10 +246,17 @@ bool BSA::canOpen( const QString & fn )
 bool BSA::open()
 {
 	QMutexLocker lock( & bsaMutex );
+
+	// An unchanged archive is read from its directory cache instead of being parsed again
+	if ( bsa.open( QIODevice::ReadOnly ) && readDirectoryCache() ) {
+		mapFile();
+		status = "loaded from cache";
+		return true;
+	}
 	
 	try
 	{
-		if ( ! bsa.open( QIODevice::ReadOnly ) )
+		if ( ! bsa.isOpen() )
 			throw QString( "file open" );
 		
 		quint32 magic;
@@ -423,18 +497,183 @@ bool BSA::open()
 		status = e;
 		return false;
 	}
-	
+
+	writeDirectoryCache();
+	mapFile();
+
 	status = "loaded successful";
 	
 	return true;
 }
 
+// see bsa.h
+void BSA::mapFile()
+{
+	// Map the whole archive so that files are read without a seek and a copy each
+	QSettings settings;
+	if ( settings.value( "Memory Map Archives", true ).toBool() ) {
+		std::unique_ptr<QFile> f( new QFile( bsaPath ) );
+		uchar * map = f->open( QIODevice::ReadOnly ) && f->size() > 0 ? f->map( 0, f->size() ) : nullptr;
+
+		if ( map ) {
+			mapped = reinterpret_cast<const char *>( map );
+			mappedSize = f->size();
+			mappedFile = std::move( f );
+		}
+	}
+}
+
+//! Marks an archive directory cache file
+static const quint32 DirectoryCacheMagic = 0x4E534244; // "NSBD"
+
+//! Format of the directory cache; bump whenever BSA::BSAFile, F4TexInfo or F4TexChunk change
+static const quint32 DirectoryCacheVersion = 1;
+
+//! Version of the QDataStream encoding of the directory cache
+static const int DirectoryCacheStreamVersion = QDataStream::Qt_5_7;
+
+//! Gets the path of the directory cache of an archive, by a hash of the archive path
+static QString directoryCachePath( const QString & bsaPath )
+{
+	QString dir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+	if ( dir.isEmpty() )
+		return QString();
+
+	QByteArray hash = QCryptographicHash::hash( bsaPath.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+	return QDir( dir ).filePath( "archives/" + QString::fromLatin1( hash ) + ".cache" );
+}
+
+// see bsa.h
+bool BSA::readDirectoryCache()
+{
+	QFile f( directoryCachePath( bsaPath ) );
+	if ( f.fileName().isEmpty() || !f.open( QIODevice::ReadOnly ) )
+		return false;
+
+	QByteArray data = f.readAll();
+	QDataStream ds( data );
+	ds.setVersion( DirectoryCacheStreamVersion );
+
+	quint32 magic = 0, format = 0;
+	QString path;
+	qint64 size = 0, modified = 0;
+	ds >> magic >> format >> path >> size >> modified;
+
+	// The cache is only used for the same archive, unchanged since it was written
+	if ( ds.status() != QDataStream::Ok || magic != DirectoryCacheMagic || format != DirectoryCacheVersion
+		 || path != bsaPath || size != bsaInfo.size() || modified != bsaInfo.lastModified().toMSecsSinceEpoch() )
+		return false;
+
+	quint32 folderCount = 0;
+	ds >> version >> namePrefix >> compressToggle >> numFiles >> folderCount;
+
+	// Counts are checked against the header and the bytes left, so a corrupt cache cannot allocate much
+	auto remaining = [&ds, &data]() { return qint64( data.size() ) - ds.device()->pos(); };
+	qint64 filesLeft = numFiles;
+
+	for ( quint32 i = 0; i < folderCount && ds.status() == QDataStream::Ok; i++ ) {
+		QString folderName;
+		quint32 fileCount = 0;
+		ds >> folderName >> fileCount;
+
+		if ( fileCount > filesLeft ) {
+			ds.setStatus( QDataStream::ReadCorruptData );
+			break;
+		}
+		filesLeft -= fileCount;
+
+		BSAFolder * folder = insertFolder( folderName );
+
+		for ( quint32 j = 0; j < fileCount && ds.status() == QDataStream::Ok; j++ ) {
+			QString name;
+			quint32 chunkCount = 0;
+
+			BSAFile * file = new BSAFile;
+			ds >> name >> file->sizeFlags >> file->packedLength >> file->unpackedLength >> file->offset;
+			ds.readRawData( (char *)&file->tex.header, sizeof( F4TexInfo ) );
+			ds >> chunkCount;
+
+			if ( qint64( chunkCount ) * qint64( sizeof( F4TexChunk ) ) > remaining() )
+				ds.setStatus( QDataStream::ReadCorruptData );
+
+			file->tex.chunks.resize( ds.status() == QDataStream::Ok ? chunkCount : 0 );
+			ds.readRawData( (char *)file->tex.chunks.data(), file->tex.chunks.count() * sizeof( F4TexChunk ) );
+
+			folder->files.insert( name, file );
+			files.insert( QString( folder->name % "/" % name ).toLower(), file );
+		}
+	}
+
+	if ( ds.status() != QDataStream::Ok ) {
+		// Parse the archive instead
+		qDeleteAll( root->children );
+		qDeleteAll( root->files );
+		root->children.clear();
+		root->files.clear();
+		folders.clear();
+		files.clear();
+		return false;
+	}
+
+	return true;
+}
+
+// see bsa.h
+void BSA::writeDirectoryCache() const
+{
+	QString fileName = directoryCachePath( bsaPath );
+	if ( fileName.isEmpty() )
+		return;
+
+	QByteArray data;
+	QDataStream ds( &data, QIODevice::WriteOnly );
+	ds.setVersion( DirectoryCacheStreamVersion );
+
+	ds << DirectoryCacheMagic << DirectoryCacheVersion << bsaPath << bsaInfo.size()
+		<< bsaInfo.lastModified().toMSecsSinceEpoch();
+
+	QVector<const BSAFolder *> list;
+	list.reserve( folders.count() + 1 );
+	list.append( root );
+	for ( const BSAFolder * folder : folders )
+		list.append( folder );
+
+	ds << version << namePrefix << compressToggle << numFiles << quint32( list.count() );
+
+	for ( const BSAFolder * folder : list ) {
+		ds << folder->name << quint32( folder->files.count() );
+
+		for ( auto it = folder->files.constBegin(); it != folder->files.constEnd(); ++it ) {
+			const BSAFile * file = it.value();
+
+			ds << it.key() << file->sizeFlags << file->packedLength << file->unpackedLength << file->offset;
+			ds.writeRawData( (const char *)&file->tex.header, sizeof( F4TexInfo ) );
+			ds << quint32( file->tex.chunks.count() );
+			ds.writeRawData( (const char *)file->tex.chunks.constData(), file->tex.chunks.count() * sizeof( F4TexChunk ) );
+		}
+	}
+
+	QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+
+	QSaveFile f( fileName );
+	if ( f.open( QIODevice::WriteOnly ) && f.write( data ) == data.size() )
+		f.commit();
+}
+
 // see bsa.h
 void BSA::close()
 {
 	QMutexLocker lock( & bsaMutex );
 	
 	bsa.close();
+	qDeleteAll( readers );
+	readers.clear();
+
+	// Nothing returned by fileContents() points into the mapping, so it goes with the archive
+	mapped = nullptr;
+	mappedSize = 0;
+	mappedFile.reset();
+
 	qDeleteAll( root->children );
 	qDeleteAll( root->files );
 	root->children.clear();
@@ -455,199 +694,270 @@ qint64 BSA::fileSize( const QString & fn ) const
 	return 0;
 }
 
+// see bsa.h
+bool BSA::read( qint64 offset, char * data, qint64 size )
+{
+	if ( mapped ) {
+		if ( offset < 0 || size < 0 || offset + size > mappedSize )
+			return false;
+
+		memcpy( data, mapped + offset, size );
+		return true;
+	}
+
+	// Each reader has its own file position, so reads and decompression can overlap
+	std::unique_ptr<QFile> reader;
+	{
+		QMutexLocker lock( & bsaMutex );
+		if ( !readers.isEmpty() )
+			reader.reset( readers.takeLast() );
+	}
+
+	if ( !reader ) {
+		reader.reset( new QFile( bsaPath ) );
+		if ( !reader->open( QIODevice::ReadOnly ) )
+			return false;
+	}
+
+	bool ok = reader->seek( offset ) && reader->read( data, size ) == size;
+
+	QMutexLocker lock( & bsaMutex );
+	readers.append( reader.release() );
+
+	return ok;
+}
+
+// see bsa.h
+QByteArray BSA::bytes( qint64 offset, qint64 size )
+{
+	if ( offset < 0 || size < 0 || size > INT_MAX )
+		return QByteArray();
+
+	if ( mapped ) {
+		if ( offset + size > mappedSize )
+			return QByteArray();
+
+		return QByteArray::fromRawData( mapped + offset, int( size ) );
+	}
+
+	QByteArray data( int( size ), Qt::Uninitialized );
+	if ( !read( offset, data.data(), size ) )
+		return QByteArray();
+
+	return data;
+}
+
 // see bsa.h
 bool BSA::fileContents( const QString & fn, QByteArray & content )
 {
 	//qDebug() << "entering fileContents for" << fn;
 	if ( const BSAFile * file = getFile( fn ) )
 	{
-		QMutexLocker lock( & bsaMutex );
-		if ( bsa.seek( file->offset ) )
-		{
-			qint64 filesz = file->size();
-			bool ok = true;
-			if (namePrefix) {
-				char len;
-				ok = bsa.read(&len, 1);
-				filesz -= len + 1;
-				if (ok) ok = bsa.seek( file->offset + 1 + len );
-			}
+		qint64 offset = file->offset;
+		qint64 filesz = file->size();
+		bool ok = true;
+		if (namePrefix) {
+			char len;
+			ok = read( offset, &len, 1 );
+			filesz -= len + 1;
+			offset += 1 + len;
+		}
 
-			quint32 filesize = filesz;
-			if ( version == SSE_BSAHEADER_VERSION && file->sizeFlags > 0 && (file->compressed() ^ compressToggle) ) {
-				ok = bsa.read( (char*)&filesize, 4 );
-				filesz -= 4;
-			}
+		quint32 filesize = filesz;
+		if ( version == SSE_BSAHEADER_VERSION && file->sizeFlags > 0 && (file->compressed() ^ compressToggle) ) {
+			ok = ok && read( offset, (char*)&filesize, 4 );
+			offset += 4;
+			filesz -= 4;
+		}
 
-			content.resize( filesz );
-			if ( ok && bsa.read( content.data(), filesz ) == filesz ) {
-				if ( file->sizeFlags > 0 && (file->compressed() ^ compressToggle) ) {
-					// BSA
-					if ( version != SSE_BSAHEADER_VERSION ) {
-						content.remove( 0, 4 );
-						QByteArray tmp3( content );
+		// The stored data, as a view into the mapping if the archive is mapped; textures are stored in chunks
+		QByteArray stored;
+		if ( ok && !file->tex.chunks.count() ) {
+			stored = bytes( offset, filesz );
+			ok = stored.size() == filesz;
+		}
 
-						content = gUncompress( tmp3, filesz - 4 );
-					} else {
-						QByteArray tmp;
-						tmp.resize( filesize );
+		if ( ok ) {
+			if ( file->sizeFlags > 0 && (file->compressed() ^ compressToggle) ) {
+				// BSA
+				if ( version != SSE_BSAHEADER_VERSION ) {
+					// The unpacked size precedes the zlib data
+					quint32 unpacked = 0;
+					if ( filesz >= 4 )
+						memcpy( &unpacked, stored.constData(), 4 );
 
-						LZ4F_decompressionContext_t dCtx = nullptr;
-						LZ4F_createDecompressionContext( &dCtx, LZ4F_VERSION );
-						size_t dstSize = filesize;
-						size_t srcSize = content.size();
+					content = gUncompress( stored.constData() + 4, filesz - 4, int( unpacked ) );
+				} else {
+					content = QByteArray( int( filesize ), Qt::Uninitialized );
 
-						LZ4F_decompressOptions_t options = {};
+					LZ4F_decompressionContext_t dCtx = nullptr;
+					LZ4F_createDecompressionContext( &dCtx, LZ4F_VERSION );
+					size_t dstSize = filesize;
+					size_t srcSize = stored.size();
 
-						LZ4F_decompress( dCtx, tmp.data(), &dstSize, content.data(), &srcSize, &options );
-						LZ4F_errorCode_t error = LZ4F_freeDecompressionContext( dCtx );
-						if ( error ) {
-							// TODO: Message logger
-							qDebug() << fn << "Error Code: " << error;
-						}
+					LZ4F_decompressOptions_t options = {};
 
-						content = tmp;
-					}
-				} else if ( file->packedLength > 0 && !file->tex.chunks.count() ) {
-					// General BA2
-					QByteArray tmp( content );
-					content.resize( file->unpackedLength );
-					content = gUncompress( tmp, file->packedLength );
-				} else if ( file->tex.chunks.count() ) {
-					// Fill DDS Header
-					DDS_HEADER ddsHeader = {};
-					DDS_HEADER_DXT10 dx10Header = {};
-
-					bool dx10 = false;
-
-					ddsHeader.dwSize = sizeof( ddsHeader );
-					ddsHeader.dwHeaderFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | DDS_HEADER_FLAGS_MIPMAP;
-					ddsHeader.dwHeight = file->tex.header.height;
-					ddsHeader.dwWidth = file->tex.header.width;
-					ddsHeader.dwMipMapCount = file->tex.header.numMips;
-					ddsHeader.ddspf.dwSize = sizeof( DDS_PIXELFORMAT );
-					ddsHeader.dwSurfaceFlags = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
-
-					if ( file->tex.header.unk16 == 2049 )
-						ddsHeader.dwCubemapFlags = DDS_CUBEMAP_ALLFACES;
-
-					bool supported = true;
-
-					switch ( file->tex.header.format ) {
-					case DXGI_FORMAT_BC1_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_FOURCC;
-						ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '1' );
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height / 2;	// 4bpp
-						break;
-
-					case DXGI_FORMAT_BC2_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_FOURCC;
-						ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '3' );
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
-						break;
-
-					case DXGI_FORMAT_BC3_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_FOURCC;
-						ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '5' );
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
-						break;
-
-					case DXGI_FORMAT_BC5_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_FOURCC;
-						ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'A', 'T', 'I', '2' );
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
-						break;
-
-					case DXGI_FORMAT_B8G8R8A8_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_RGBA;
-						ddsHeader.ddspf.dwRGBBitCount = 32;
-						ddsHeader.ddspf.dwRBitMask = 0x00FF0000;
-						ddsHeader.ddspf.dwGBitMask = 0x0000FF00;
-						ddsHeader.ddspf.dwBBitMask = 0x000000FF;
-						ddsHeader.ddspf.dwABitMask = 0xFF000000;
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height * 4;	// 32bpp
-						break;
-
-					case DXGI_FORMAT_R8_UNORM:
-						ddsHeader.ddspf.dwFlags = DDS_RGB;
-						ddsHeader.ddspf.dwRGBBitCount = 8;
-						ddsHeader.ddspf.dwRBitMask = 0xFF;
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
-						break;
-
-					case DXGI_FORMAT_BC7_UNORM:
-					case DXGI_FORMAT_BC1_UNORM_SRGB:
-					case DXGI_FORMAT_BC2_UNORM_SRGB:
-					case DXGI_FORMAT_BC3_UNORM_SRGB:
-					case DXGI_FORMAT_BC7_UNORM_SRGB:
-						ddsHeader.ddspf.dwFlags = DDS_FOURCC;
-						ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
-						ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;
-
-						dx10 = true;
-						dx10Header.dxgiFormat = DXGI_FORMAT( file->tex.header.format );
-						break;
-
-					default:
-						supported = false;
-						break;
+					LZ4F_decompress( dCtx, content.data(), &dstSize, stored.constData(), &srcSize, &options );
+					LZ4F_errorCode_t error = LZ4F_freeDecompressionContext( dCtx );
+					if ( error ) {
+						// TODO: Message logger
+						qDebug() << fn << "Error Code: " << error;
 					}
+				}
+			} else if ( file->packedLength > 0 && !file->tex.chunks.count() ) {
+				// General BA2
+				content = gUncompress( stored.constData(), file->packedLength, file->unpackedLength );
+			} else if ( !file->tex.chunks.count() ) {
+				// Uncompressed; copied out of the mapping, which does not outlive the archive
+				content = mapped ? QByteArray( stored.constData(), stored.size() ) : stored;
+			} else {
+				// Fill DDS Header
+				DDS_HEADER ddsHeader = {};
+				DDS_HEADER_DXT10 dx10Header = {};
+
+				bool dx10 = false;
+
+				ddsHeader.dwSize = sizeof( ddsHeader );
+				ddsHeader.dwHeaderFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE | DDS_HEADER_FLAGS_MIPMAP;
+				ddsHeader.dwHeight = file->tex.header.height;
+				ddsHeader.dwWidth = file->tex.header.width;
+				ddsHeader.dwMipMapCount = file->tex.header.numMips;
+				ddsHeader.ddspf.dwSize = sizeof( DDS_PIXELFORMAT );
+				ddsHeader.dwSurfaceFlags = DDS_SURFACE_FLAGS_TEXTURE | DDS_SURFACE_FLAGS_MIPMAP;
+
+				if ( file->tex.header.unk16 == 2049 )
+					ddsHeader.dwCubemapFlags = DDS_CUBEMAP_ALLFACES;
+
+				bool supported = true;
+
+				switch ( file->tex.header.format ) {
+				case DXGI_FORMAT_BC1_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_FOURCC;
+					ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '1' );
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height / 2;	// 4bpp
+					break;
+
+				case DXGI_FORMAT_BC2_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_FOURCC;
+					ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '3' );
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
+					break;
+
+				case DXGI_FORMAT_BC3_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_FOURCC;
+					ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', 'T', '5' );
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
+					break;
+
+				case DXGI_FORMAT_BC5_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_FOURCC;
+					ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'A', 'T', 'I', '2' );
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
+					break;
+
+				case DXGI_FORMAT_B8G8R8A8_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_RGBA;
+					ddsHeader.ddspf.dwRGBBitCount = 32;
+					ddsHeader.ddspf.dwRBitMask = 0x00FF0000;
+					ddsHeader.ddspf.dwGBitMask = 0x0000FF00;
+					ddsHeader.ddspf.dwBBitMask = 0x000000FF;
+					ddsHeader.ddspf.dwABitMask = 0xFF000000;
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height * 4;	// 32bpp
+					break;
+
+				case DXGI_FORMAT_R8_UNORM:
+					ddsHeader.ddspf.dwFlags = DDS_RGB;
+					ddsHeader.ddspf.dwRGBBitCount = 8;
+					ddsHeader.ddspf.dwRBitMask = 0xFF;
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;	// 8bpp
+					break;
+
+				case DXGI_FORMAT_BC7_UNORM:
+				case DXGI_FORMAT_BC1_UNORM_SRGB:
+				case DXGI_FORMAT_BC2_UNORM_SRGB:
+				case DXGI_FORMAT_BC3_UNORM_SRGB:
+				case DXGI_FORMAT_BC7_UNORM_SRGB:
+					ddsHeader.ddspf.dwFlags = DDS_FOURCC;
+					ddsHeader.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
+					ddsHeader.dwPitchOrLinearSize = file->tex.header.width * file->tex.header.height;
+
+					dx10 = true;
+					dx10Header.dxgiFormat = DXGI_FORMAT( file->tex.header.format );
+					break;
+
+				default:
+					supported = false;
+					break;
+				}
+
+				if ( !supported )
+					return false;
+
+				if ( dx10 ) {
+					dx10Header.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+					dx10Header.miscFlag = 0;
+					dx10Header.arraySize = 1;
+					dx10Header.miscFlags2 = 0;
+				}
 
-					if ( !supported )
-						return false;
+				int hdrSize = 4 + sizeof( ddsHeader ) + ( dx10 ? sizeof( dx10Header ) : 0 );
 
-					char dds[sizeof( ddsHeader )];
-					memcpy( dds, &ddsHeader, sizeof( ddsHeader ) );
+				// The chunks are unpacked straight to their offsets in the texture, after the header
+				qint64 texSize = 0;
+				QVector<qint64> chunkOffsets;
+				chunkOffsets.reserve( file->tex.chunks.count() );
+				for ( const F4TexChunk & chunk : file->tex.chunks ) {
+					chunkOffsets.append( hdrSize + texSize );
+					texSize += chunk.unpackedSize;
+				}
 
-					int texSize = 0; // = file->unpackedLength;
-					int hdrSize = sizeof( ddsHeader ) + 4;
+				if ( hdrSize + texSize > INT_MAX )
+					return false;
 
-					content.clear();
-					content.append( QByteArray::fromStdString( "DDS " ) );
-					content.append( QByteArray::fromRawData( dds, sizeof( ddsHeader ) ) );
-					Q_ASSERT( content.size() == hdrSize );
+				content = QByteArray( int( hdrSize + texSize ), Qt::Uninitialized );
+				char * out = content.data();
 
-					if ( dx10 ) {
-						dx10Header.resourceDimension = DDS_DIMENSION_TEXTURE2D;
-						dx10Header.miscFlag = 0;
-						dx10Header.arraySize = 1;
-						dx10Header.miscFlags2 = 0;
+				memcpy( out, "DDS ", 4 );
+				memcpy( out + 4, &ddsHeader, sizeof( ddsHeader ) );
+				if ( dx10 )
+					memcpy( out + 4 + sizeof( ddsHeader ), &dx10Header, sizeof( dx10Header ) );
 
-						char dds2[sizeof( dx10Header )];
-						memcpy( dds2, &dx10Header, sizeof( dx10Header ) );
-						content.append( QByteArray::fromRawData( dds2, sizeof( dx10Header ) ) );
-					}
+				// The chunks of large textures are independent mips, which are inflated concurrently
+				QThreadPool pool;
+				bool parallel = file->tex.chunks.count() > 1 && texSize >= ParallelTextureSize && QThread::idealThreadCount() > 1;
+				if ( parallel )
+					pool.setMaxThreadCount( qMin( file->tex.chunks.count(), QThread::idealThreadCount() ) );
+
+				for ( int i = 0; i < file->tex.chunks.count(); i++ ) {
+					const F4TexChunk & chunk = file->tex.chunks.at( i );
+					char * chunkOut = out + chunkOffsets.at( i );
+
+					if ( chunk.unpackedSize == 0 )
+						continue;
 
-					// Start at 1st chunk now
-					for ( int i = 0; i < file->tex.chunks.count(); i++ ) {
-						F4TexChunk chunk = file->tex.chunks[i];
-						if ( bsa.seek( chunk.offset ) ) {
-							QByteArray chunkData;
-
-							if ( chunk.packedSize > 0 ) {
-								chunkData.resize( chunk.packedSize );
-								if ( bsa.read( chunkData.data(), chunk.packedSize ) == chunk.packedSize ) {
-									chunkData = gUncompress( chunkData, chunk.packedSize );
-
-									if ( chunkData.size() != chunk.unpackedSize )
-										qCritical() << "Size does not match at " << chunk.offset;
-								}
-							} else if ( !(bsa.read( chunkData.data(), chunk.unpackedSize ) == chunk.unpackedSize) ) {
-								qCritical() << "Size does not match at " << chunk.offset;
-							}
-							texSize += chunk.unpackedSize;
-
-							content.append( chunkData );
-							//Q_ASSERT( content.size() - hdrSize == texSize );
+					QByteArray stored = bytes( chunk.offset, chunk.packedSize > 0 ? chunk.packedSize : chunk.unpackedSize );
+
+					if ( chunk.packedSize == 0 ) {
+						if ( stored.size() == int( chunk.unpackedSize ) ) {
+							memcpy( chunkOut, stored.constData(), chunk.unpackedSize );
 						} else {
-							qCritical() << "Seek error";
+							qCritical() << "Size does not match at " << chunk.offset;
+							memset( chunkOut, 0, chunk.unpackedSize );
 						}
+					} else if ( stored.size() != int( chunk.packedSize ) ) {
+						qCritical() << "Read error at " << chunk.offset;
+						memset( chunkOut, 0, chunk.unpackedSize );
+					} else if ( parallel ) {
+						pool.start( new TexChunkTask( stored, chunk, chunkOut ) );
+					} else {
+						TexChunkTask( stored, chunk, chunkOut ).run();
 					}
-
 				}
 
-				return true;
+				pool.waitForDone();
 			}
+
+			return true;
 		}
 	}
 	return false;
@@ -44,6 +44,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QFileInfo>
 #include <QHash>
 #include <QMutex>
+#include <QVector>
 
 #include <memory>
 
@@ -260,6 +261,8 @@ public:
 	bool hasFile( const QString & ) const override final;
 	//! Returns the size of the file per BSAFile::size().
 	qint64 fileSize( const QString & ) const override final;
+	//! Returns the keys of BSA::files.
+	QStringList fileList() const override final { return files.keys(); }
 	//! Returns the contents of the specified file
 	/*!
 	* \param fn The filename to get the contents for
@@ -334,6 +337,20 @@ public:
 	bool fillModel( BSAModel *, const QString & );
 
 protected:
+	//! Reads from the %BSA at an offset, with a file handle no other thread is reading from
+	bool read( qint64 offset, char * data, qint64 size );
+	//! Gets the bytes of the %BSA at an offset, empty on failure
+	/*!
+	* The bytes of a mapped %BSA are a view into the mapping, which is only valid until the %BSA is closed.
+	*/
+	QByteArray bytes( qint64 offset, qint64 size );
+	//! Maps the %BSA into memory, if the "Memory Map Archives" setting is on
+	void mapFile();
+
+	//! Reads the folders and files from the directory cache, if it was written for the %BSA as it is
+	bool readDirectoryCache();
+	//! Writes the parsed folders and files to the directory cache, keyed by the path, size and modification time
+	void writeDirectoryCache() const;
 	
 	//! The %BSA file
 	QFile bsa;
@@ -342,8 +359,17 @@ protected:
 
 	quint32 version = 0;
 
-	//! Mutual exclusion handler
+	//! Mutual exclusion handler; only held while opening, closing or taking a reader
 	QMutex bsaMutex;
+	//! Handles on the %BSA file which no thread is reading from, see read()
+	QVector<QFile *> readers;
+
+	//! The %BSA file mapped into memory, with the "Memory Map Archives" setting
+	std::unique_ptr<QFile> mappedFile;
+	//! The mapped bytes of the %BSA, or null if it is not mapped
+	const char * mapped = nullptr;
+	//! The size of the mapping
+	qint64 mappedSize = 0;
 	
 	//! The absolute name of the file, e.g. "d:/temp/test.bsa"
 	QString bsaPath;
@@ -85,6 +85,8 @@ public:
 	virtual bool hasFolder( const QString & ) const = 0;
 	virtual bool hasFile( const QString & ) const = 0;
 	virtual qint64 fileSize( const QString & ) const = 0;
+	//! Gets the paths of all files, in lower case with forward slashes
+	virtual QStringList fileList() const = 0;
 	virtual bool fileContents( const QString &, QByteArray & ) = 0;
 	virtual QString getAbsoluteFilePath( const QString & ) const = 0;
 
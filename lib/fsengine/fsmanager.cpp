@@ -65,13 +65,50 @@ void FSManager::del()
 // see fsmanager.h
 QList <FSArchiveFile *> FSManager::archiveList()
 {
+	FSManager * mgr = get();
+
 	QList<FSArchiveFile *> archives;
-	for ( std::shared_ptr<FSArchiveHandler> an : get()->archives.values() ) {
-		archives.append( an->getArchive() );
+	for ( const QString & an : mgr->archiveOrder ) {
+		if ( std::shared_ptr<FSArchiveHandler> a = mgr->archives.value( an ) )
+			archives.append( a->getArchive() );
 	}
 	return archives;
 }
 
+// see fsmanager.h
+QString FSManager::normalizePath( const QString & path )
+{
+	QString p = path.toLower().replace( '\\', '/' );
+
+	int start = 0;
+	while ( start < p.length() && p.at( start ) == '/' )
+		start++;
+
+	return p.mid( start );
+}
+
+// see fsmanager.h
+bool FSManager::fileContents( const QString & path, QByteArray & content )
+{
+	FSManager * mgr = get();
+
+	IndexEntry entry = mgr->fileIndex.value( normalizePath( path ) );
+	if ( !entry.archive )
+		return false;
+
+	if ( entry.archive->fileContents( entry.path, content ) && !content.isEmpty() )
+		return true;
+
+	// The file could not be read from the first archive which has it; try the archives after it
+	QList<FSArchiveFile *> list = archiveList();
+	for ( int i = list.indexOf( entry.archive ) + 1; i < list.count(); i++ ) {
+		if ( list.at( i )->hasFile( entry.path ) && list.at( i )->fileContents( entry.path, content ) && !content.isEmpty() )
+			return true;
+	}
+
+	return false;
+}
+
 // see fsmanager.h
 FSManager::FSManager( QObject * parent )
 	: QObject( parent ), automatic( false )
@@ -90,9 +127,40 @@ void FSManager::initialize()
 	QSettings cfg;
 	QStringList list = cfg.value( "Settings/Resources/Archives", QStringList() ).toStringList();
 
+	registerArchives( list );
+}
+
+void FSManager::registerArchives( const QStringList & list )
+{
+	archives.clear();
+	archiveOrder.clear();
+
 	for ( const QString an : list ) {
-		if ( auto a = FSArchiveHandler::openArchive( an ) )
+		if ( archives.contains( an ) )
+			continue;
+
+		if ( auto a = FSArchiveHandler::openArchive( an ) ) {
 			archives.insert( an, a );
+			archiveOrder.append( an );
+		}
+	}
+
+	buildIndex();
+}
+
+void FSManager::buildIndex()
+{
+	fileIndex.clear();
+
+	for ( FSArchiveFile * archive : archiveList() ) {
+		for ( const QString & fn : archive->fileList() ) {
+			// The paths are already lower case with forward slashes; only files in the root of an archive have a leading slash
+			QString key = fn.startsWith( '/' ) ? normalizePath( fn ) : fn;
+
+			// An archive registered earlier takes precedence
+			if ( !fileIndex.contains( key ) )
+				fileIndex.insert( key, { archive, fn } );
+		}
 	}
 }
 
@@ -36,8 +36,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include <QDialog>
+#include <QHash>
 #include <QObject>
 #include <QMap>
+#include <QStringList>
 
 #include <memory>
 
@@ -55,9 +57,14 @@ public:
 	//! Deletes the manager
 	static void del();
 
-	//! Gets the list of globally registered BSA files
+	//! Gets the list of globally registered BSA files, in the order they were registered
 	static QList<FSArchiveFile *> archiveList();
 
+	//! Gets the contents of a file from the first registered archive which has it and can read it
+	static bool fileContents( const QString & path, QByteArray & content );
+	//! Converts a path to the form of the index: lower case, with forward slashes and no leading slash
+	static QString normalizePath( const QString & path );
+
 	//! Filters a list of BSAs from a provided list
 	static QStringList filterArchives( const QStringList & list, const QString & folder = "" );
 
@@ -69,6 +76,18 @@ protected:
 	
 protected:
 	QMap<QString, std::shared_ptr<FSArchiveHandler> > archives;
+	//! The paths of the archives in the order they were registered; earlier archives take precedence
+	QStringList archiveOrder;
+	//! A file of the index
+	struct IndexEntry
+	{
+		//! The first registered archive which has the file
+		FSArchiveFile * archive = nullptr;
+		//! The path of the file as the archive names it
+		QString path;
+	};
+	//! The files of all registered archives, by normalized path
+	QHash<QString, IndexEntry> fileIndex;
 	bool automatic;
 	
 	//! Builds a list of global BSAs on Windows platforms
@@ -77,6 +96,10 @@ protected:
 	static QStringList regPathBSAList( QString regKey, QString dataDir );
 
 	void initialize();
+	//! Opens and registers a list of archives in order, replacing the registered ones
+	void registerArchives( const QStringList & list );
+	//! Rebuilds the file index from the registered archives
+	void buildIndex();
 	
 	friend class NifSkope;
 	friend class SettingsResources;
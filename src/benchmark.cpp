@@ -0,0 +1,801 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2017, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "benchmark.h"
+
+#include "data/nifitem.h"
+#include "data/niftypes.h"
+#include "io/nifstream.h"
+#include "model/kfmmodel.h"
+#include "model/nifmodel.h"
+
+#include <fsengine/fsengine.h>
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+
+//! @file benchmark.cpp Benchmark
+
+//! The file types loaded by NifModel
+static const QStringList nifFilters = { "*.nif", "*.nifcache", "*.kf", "*.kfa", "*.texcache", "*.pcpatch", "*.jmi" };
+
+//! The standard output of the benchmarks
+static QTextStream & out()
+{
+	static QTextStream stream( stdout );
+	return stream;
+}
+
+//! Milliseconds with a fraction
+static QString msecs( qint64 nsecs )
+{
+	return QString::number( double( nsecs ) / 1e6, 'f', 2 );
+}
+
+//! Megabytes per second
+static QString throughput( qint64 bytes, qint64 nsecs )
+{
+	return QString::number( nsecs > 0 ? double( bytes ) * 1e3 / double( nsecs ) : 0.0, 'f', 1 );
+}
+
+//! Extracts a slice of the files of an archive on a thread pool
+class ExtractTask final : public QRunnable
+{
+public:
+	ExtractTask( FSArchiveFile * archive, const QStringList & files, qint64 & bytes, int & failed )
+		: archive( archive ), files( files ), bytes( bytes ), failed( failed ) {}
+
+	void run() override final
+	{
+		QByteArray data;
+		for ( const QString & file : files ) {
+			if ( archive->fileContents( file, data ) )
+				bytes += data.size();
+			else
+				failed++;
+		}
+	}
+
+private:
+	FSArchiveFile * archive;
+	QStringList files;
+	qint64 & bytes;
+	int & failed;
+};
+
+//! A benchmark that can be run by name
+struct BenchmarkEntry
+{
+	const char * name;
+	const char * description;
+	int ( *run )( const QStringList & paths );
+};
+
+int Benchmark::run( const QString & name, const QStringList & paths )
+{
+	static const BenchmarkEntry entries[] = {
+		{ "expressions", "Condition evaluation, compiled against the QVariant tree, over NIF files", &Benchmark::expressions },
+		{ "memory", "Memory use and getArray() of NIF files, with packed arrays against one item per element", &Benchmark::memory },
+		{ "load", "Load throughput of NIF files", &Benchmark::load },
+		{ "arrays", "Read throughput of fixed size arrays, in bulk against one value at a time", &Benchmark::arrays },
+		{ "schema", "Parsing of nif.xml and kfm.xml, without and with the schema cache", &Benchmark::schema },
+		{ "rows", "Resizing a 100000 item array in place and the rows of its items", &Benchmark::rows },
+		{ "lookup", "Finding the fields of the blocks of NIF files by name, by field ID and by a scan", &Benchmark::lookup },
+		{ "archives", "Extracting up to 10000 files from each BSA or BA2 with 1 to all threads", &Benchmark::archives },
+		{ "textures", "Extracting every texture of BA2 archives", &Benchmark::textures },
+	};
+
+	for ( const BenchmarkEntry & e : entries ) {
+		if ( name == QLatin1String( e.name ) )
+			return e.run( paths );
+	}
+
+	out() << "Benchmarks:" << endl;
+	for ( const BenchmarkEntry & e : entries )
+		out() << "  " << e.name << "\t" << e.description << endl;
+
+	return name == QLatin1String( "help" ) ? 0 : 1;
+}
+
+QString Benchmark::schemaPath( const QString & name )
+{
+	QDir dir( QCoreApplication::applicationDirPath() );
+	QString fname = dir.filePath( name );
+#ifdef Q_OS_LINUX
+	if ( !QFileInfo( fname ).exists() )
+		fname = "/usr/share/nifskope/" + name;
+#endif
+
+	return fname;
+}
+
+bool Benchmark::loadSchema()
+{
+	QString result = NifModel::parseXmlDescription( schemaPath( "nif.xml" ) );
+	if ( !result.isEmpty() ) {
+		out() << result << endl;
+		return false;
+	}
+
+	return true;
+}
+
+QStringList Benchmark::findFiles( const QStringList & paths, const QStringList & filters )
+{
+	QStringList files;
+	for ( const QString & path : paths ) {
+		QFileInfo info( path );
+		if ( info.isDir() ) {
+			QDirIterator it( path, filters, QDir::Files, QDirIterator::Subdirectories );
+			while ( it.hasNext() )
+				files.append( it.next() );
+		} else if ( info.isFile() ) {
+			files.append( path );
+		}
+	}
+
+	files.sort();
+	return files;
+}
+
+void Benchmark::collectConditions( NifItem * parent, QVector<NifItem *> & items )
+{
+	// Elements of packed arrays are conditionless
+	if ( parent->isPacked() )
+		return;
+
+	for ( NifItem * child : parent->children() ) {
+		if ( !child->cond().isEmpty() && child->condexpr().isCompiled() )
+			items.append( child );
+
+		collectConditions( child, items );
+	}
+}
+
+void Benchmark::collectPacked( NifItem * parent, QVector<NifItem *> & arrays )
+{
+	if ( parent->isPacked() ) {
+		arrays.append( parent );
+		return;
+	}
+
+	for ( NifItem * child : parent->children() )
+		collectPacked( child, arrays );
+}
+
+int Benchmark::expressions( const QStringList & paths )
+{
+	if ( !loadSchema() )
+		return 1;
+
+	const int repeats = 20;
+
+	qint64 evaluations = 0, compiledTime = 0, treeTime = 0;
+	int files = 0, mismatches = 0;
+	// Kept so that the evaluations are not optimized away
+	quint32 sum = 0;
+
+	for ( const QString & file : findFiles( paths, nifFilters ) ) {
+		NifModel nif;
+		nif.setMessageMode( BaseModel::TstMessage );
+		if ( !nif.loadFromFile( file ) )
+			continue;
+
+		files++;
+
+		QVector<NifItem *> items;
+		for ( int b = 0; b < nif.getBlockCount(); b++ )
+			collectConditions( nif.getBlockItem( b ), items );
+
+		for ( NifItem * item : items ) {
+			BaseModelEval functor( &nif, item );
+			if ( ( item->condexpr().evaluateCompiled( functor ) != 0 ) != item->condexpr().evaluateValue( functor ).toBool() )
+				mismatches++;
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( NifItem * item : items )
+				sum += item->condexpr().evaluateCompiled( BaseModelEval( &nif, item ) );
+		}
+		compiledTime += timer.nsecsElapsed();
+
+		timer.restart();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( NifItem * item : items )
+				sum += item->condexpr().evaluateValue( BaseModelEval( &nif, item ) ).toUInt();
+		}
+		treeTime += timer.nsecsElapsed();
+
+		evaluations += qint64( items.count() ) * repeats;
+	}
+
+	out() << "files: " << files << ", evaluations: " << evaluations << ", mismatches: " << mismatches << endl;
+	out() << "compiled: " << msecs( compiledTime ) << " ms, "
+		<< QString::number( evaluations ? double( compiledTime ) / evaluations : 0.0, 'f', 1 ) << " ns per evaluation" << endl;
+	out() << "QVariant: " << msecs( treeTime ) << " ms, "
+		<< QString::number( evaluations ? double( treeTime ) / evaluations : 0.0, 'f', 1 ) << " ns per evaluation" << endl;
+	out() << "(checksum " << sum << ")" << endl;
+
+	return mismatches ? 1 : 0;
+}
+
+int Benchmark::memory( const QStringList & paths )
+{
+	if ( !loadSchema() )
+		return 1;
+
+	const int repeats = 10;
+
+	qint64 packedItems = 0, packedBytes = 0, rowItems = 0, rowBytes = 0;
+	qint64 packedTime = 0, rowTime = 0, elements = 0;
+	int files = 0;
+	// Kept so that the reads are not optimized away
+	float sum = 0;
+
+	for ( const QString & file : findFiles( paths, nifFilters ) ) {
+		NifModel nif;
+		nif.setMessageMode( BaseModel::TstMessage );
+		if ( !nif.loadFromFile( file ) )
+			continue;
+
+		files++;
+
+		QVector<NifItem *> arrays, vectors;
+		for ( int b = 0; b < nif.getBlockCount(); b++ )
+			collectPacked( nif.getBlockItem( b ), arrays );
+
+		for ( NifItem * array : arrays ) {
+			if ( array->packedArray()->element.value.type() == NifValue::tVector3 ) {
+				vectors.append( array );
+				elements += qint64( array->packedArray()->count ) * repeats;
+			}
+		}
+
+		nif.root->memoryUsage( packedItems, packedBytes );
+
+		QElapsedTimer timer;
+		timer.start();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( NifItem * array : vectors ) {
+				QVector<Vector3> v = array->getArray<Vector3>();
+				if ( !v.isEmpty() )
+					sum += v.first()[0];
+			}
+		}
+		packedTime += timer.nsecsElapsed();
+
+		// Create the rows of every array, one item per element as before packed storage
+		for ( NifItem * array : arrays )
+			array->children();
+
+		nif.root->memoryUsage( rowItems, rowBytes );
+
+		timer.restart();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( NifItem * array : vectors ) {
+				QVector<Vector3> v = array->getArray<Vector3>();
+				if ( !v.isEmpty() )
+					sum += v.first()[0];
+			}
+		}
+		rowTime += timer.nsecsElapsed();
+	}
+
+	out() << "files: " << files << ", Vector3 elements read: " << elements << endl;
+	out() << "packed: " << packedItems << " items, " << packedBytes << " bytes, getArray "
+		<< msecs( packedTime ) << " ms" << endl;
+	out() << "rows:   " << rowItems << " items, " << rowBytes << " bytes, getArray "
+		<< msecs( rowTime ) << " ms" << endl;
+	out() << "(checksum " << sum << ")" << endl;
+
+	return 0;
+}
+
+int Benchmark::load( const QStringList & paths )
+{
+	if ( !loadSchema() )
+		return 1;
+
+	qint64 bytes = 0, time = 0;
+	int files = 0, failed = 0;
+
+	for ( const QString & file : findFiles( paths, nifFilters ) ) {
+		NifModel nif;
+		nif.setMessageMode( BaseModel::TstMessage );
+
+		QElapsedTimer timer;
+		timer.start();
+		bool ok = nif.loadFromFile( file );
+		qint64 elapsed = timer.nsecsElapsed();
+
+		if ( !ok ) {
+			failed++;
+			continue;
+		}
+
+		files++;
+		bytes += QFileInfo( file ).size();
+		time += elapsed;
+	}
+
+	out() << "files: " << files << " (" << failed << " failed), "
+		<< QString::number( double( bytes ) / 1e6, 'f', 1 ) << " MB" << endl;
+	out() << "load: " << msecs( time ) << " ms, " << throughput( bytes, time ) << " MB/s" << endl;
+
+	return 0;
+}
+
+int Benchmark::arrays( const QStringList & paths )
+{
+	Q_UNUSED( paths );
+
+	if ( !loadSchema() )
+		return 1;
+
+	struct ArrayType
+	{
+		NifValue::Type type;
+		const char * name;
+		int fileSize;
+	};
+
+	static const ArrayType types[] = {
+		{ NifValue::tVector3, "Vector3", 12 },
+		{ NifValue::tHalfVector3, "HalfVector3", 6 },
+		{ NifValue::tVector2, "Vector2", 8 },
+		{ NifValue::tHalfVector2, "HalfVector2", 4 },
+		{ NifValue::tTriangle, "Triangle", 6 },
+		{ NifValue::tFloat, "float", 4 },
+		{ NifValue::tColor4, "Color4", 16 },
+	};
+
+	const int count = 1000000;
+
+	// Read with the defaults of a model which has not loaded a file
+	NifModel nif;
+	int failed = 0;
+	float sum = 0;
+
+	for ( const ArrayType & t : types ) {
+		// 0x3C00 is 1.0 as a half float, 0x3C003C00 about 0.0078 as a float
+		QByteArray data( count * t.fileSize, Qt::Uninitialized );
+		for ( int i = 0; i + 1 < data.size(); i += 2 ) {
+			data[i] = 0x00;
+			data[i + 1] = 0x3C;
+		}
+
+		NifValue element( t.type );
+		const int size = NifValue::packedSize( t.type );
+		QByteArray packed( count * size, Qt::Uninitialized );
+
+		QBuffer buffer( &data );
+		buffer.open( QIODevice::ReadOnly );
+
+		QElapsedTimer timer;
+		timer.start();
+		NifIStream bulk( &nif, &buffer );
+		bool ok = bulk.readPacked( element, packed.data(), count );
+		qint64 bulkTime = timer.nsecsElapsed();
+		ok = ok && buffer.pos() == data.size();
+		sum += float( packed.at( packed.size() - 1 ) );
+
+		buffer.seek( 0 );
+		NifValue value( t.type );
+
+		timer.restart();
+		NifIStream single( &nif, &buffer );
+		char * dst = packed.data();
+		for ( int i = 0; i < count && ok; i++, dst += size ) {
+			ok = single.read( value );
+			value.toPacked( dst );
+		}
+		qint64 singleTime = timer.nsecsElapsed();
+		ok = ok && buffer.pos() == data.size();
+		sum += float( packed.at( packed.size() - 1 ) );
+
+		if ( !ok ) {
+			out() << t.name << ": read failed" << endl;
+			failed++;
+			continue;
+		}
+
+		out() << t.name << ": bulk " << throughput( data.size(), bulkTime ) << " MB/s, one at a time "
+			<< throughput( data.size(), singleTime ) << " MB/s" << endl;
+	}
+
+	out() << "(checksum " << sum << ")" << endl;
+
+	return failed ? 1 : 0;
+}
+
+int Benchmark::schema( const QStringList & paths )
+{
+	Q_UNUSED( paths );
+
+	struct Schema
+	{
+		const char * name;
+		QString ( *parse )( const QString & filename );
+	};
+
+	static const Schema schemas[] = {
+		{ "nif.xml", &NifModel::parseXmlDescription },
+		{ "kfm.xml", &KfmModel::parseXmlDescription },
+	};
+
+	const int repeats = 10;
+
+	// Keep the cache of the application untouched
+	QStandardPaths::setTestModeEnabled( true );
+	QDir cacheDir( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) );
+
+	for ( const Schema & s : schemas ) {
+		QString fname = schemaPath( s.name );
+		QString cacheFile = cacheDir.filePath( QString( s.name ) + ".cache" );
+
+		qint64 coldTime = 0, cachedTime = 0;
+		QString result;
+
+		for ( int r = 0; r < repeats && result.isEmpty(); r++ ) {
+			QFile::remove( cacheFile );
+
+			QElapsedTimer timer;
+			timer.start();
+			result = s.parse( fname );
+			coldTime += timer.nsecsElapsed();
+		}
+
+		for ( int r = 0; r < repeats && result.isEmpty(); r++ ) {
+			QElapsedTimer timer;
+			timer.start();
+			result = s.parse( fname );
+			cachedTime += timer.nsecsElapsed();
+		}
+
+		QFile::remove( cacheFile );
+
+		if ( !result.isEmpty() ) {
+			out() << s.name << ": " << result << endl;
+			return 1;
+		}
+
+		out() << s.name << ": parsed " << msecs( coldTime / repeats ) << " ms, cached "
+			<< msecs( cachedTime / repeats ) << " ms" << endl;
+	}
+
+	return 0;
+}
+
+int Benchmark::rows( const QStringList & paths )
+{
+	Q_UNUSED( paths );
+
+	if ( !loadSchema() )
+		return 1;
+
+	const int count = 100000;
+	const int removals = 100;
+
+	NifModel nif;
+	nif.setMessageMode( BaseModel::TstMessage );
+
+	// Links are held as one item per element, unlike packed arrays
+	QModelIndex iBlock = nif.insertNiBlock( "NiNode" );
+	QModelIndex iChildren = nif.getIndex( iBlock, "Children" );
+	if ( !iChildren.isValid() ) {
+		out() << "NiNode has no Children" << endl;
+		return 1;
+	}
+
+	NifItem * children = static_cast<NifItem *>( iChildren.internalPointer() );
+
+	auto resize = [&nif, &iBlock, &iChildren]( int n ) {
+		QElapsedTimer timer;
+		timer.start();
+		nif.set<int>( iBlock, "Num Children", n );
+		nif.updateArray( iChildren );
+		return timer.nsecsElapsed();
+	};
+
+	qint64 growTime = resize( count );
+	if ( children->childCount() != count ) {
+		out() << "Children has " << children->childCount() << " items instead of " << count << endl;
+		return 1;
+	}
+
+	// Kept so that the rows are not optimized away
+	qint64 sum = 0;
+
+	QElapsedTimer timer;
+	timer.start();
+	for ( NifItem * child : children->children() )
+		sum += child->row();
+	qint64 rowTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for ( int r = 0; r < removals; r++ )
+		nif.removeRows( count / 2, 1, iChildren );
+	qint64 removeTime = timer.nsecsElapsed();
+
+	timer.restart();
+	for ( NifItem * child : children->children() )
+		sum += child->row();
+	qint64 rowAfterRemoveTime = timer.nsecsElapsed();
+
+	qint64 shrinkTime = resize( count / 2 );
+	qint64 regrowTime = resize( count );
+
+	out() << "grow to " << count << ": " << msecs( growTime ) << " ms" << endl;
+	out() << "row() of every item: " << msecs( rowTime ) << " ms" << endl;
+	out() << "remove " << removals << " items from the middle: " << msecs( removeTime ) << " ms" << endl;
+	out() << "row() of every item after removal: " << msecs( rowAfterRemoveTime ) << " ms" << endl;
+	out() << "shrink to " << count / 2 << ": " << msecs( shrinkTime ) << " ms" << endl;
+	out() << "grow to " << count << ": " << msecs( regrowTime ) << " ms" << endl;
+	out() << "(checksum " << sum << ")" << endl;
+
+	return 0;
+}
+
+int Benchmark::lookup( const QStringList & paths )
+{
+	if ( !loadSchema() )
+		return 1;
+
+	const int repeats = 20;
+
+	qint64 lookups = 0, nameTime = 0, fieldTime = 0, scanTime = 0;
+	int files = 0, mismatches = 0;
+	// Kept so that the lookups are not optimized away
+	quintptr sum = 0;
+
+	for ( const QString & file : findFiles( paths, nifFilters ) ) {
+		NifModel nif;
+		nif.setMessageMode( BaseModel::TstMessage );
+		if ( !nif.loadFromFile( file ) )
+			continue;
+
+		files++;
+
+		// Every field of every block, as the renderer and spells look them up
+		QVector<QModelIndex> blocks;
+		QVector<QStringList> names;
+		QVector<QVector<NifFieldId>> fields;
+		for ( int b = 0; b < nif.getBlockCount(); b++ ) {
+			NifItem * block = nif.getBlockItem( b );
+			QStringList n;
+			QVector<NifFieldId> f;
+			for ( NifItem * child : block->children() ) {
+				n.append( child->name() );
+				f.append( NifFieldId( child->name() ) );
+			}
+
+			blocks.append( nif.getBlock( b ) );
+			names.append( n );
+			fields.append( f );
+			lookups += qint64( n.count() ) * repeats;
+		}
+
+		// The scan that getItem() did before the row tables
+		auto scan = [&nif]( const QModelIndex & parent, const QString & name ) {
+			NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
+			for ( NifItem * child : parentItem->children() ) {
+				if ( child->name() == name && nif.evalCondition( child ) )
+					return child;
+			}
+			return static_cast<NifItem *>( nullptr );
+		};
+
+		for ( int b = 0; b < blocks.count(); b++ ) {
+			for ( int i = 0; i < names[b].count(); i++ ) {
+				NifItem * expected = scan( blocks[b], names[b][i] );
+				QModelIndex iName = nif.getIndex( blocks[b], names[b][i] );
+				QModelIndex iField = nif.getIndex( blocks[b], fields[b][i] );
+				if ( iName.internalPointer() != expected || iField.internalPointer() != expected )
+					mismatches++;
+			}
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( int b = 0; b < blocks.count(); b++ ) {
+				for ( const QString & name : names[b] )
+					sum += quintptr( nif.getIndex( blocks[b], name ).internalPointer() );
+			}
+		}
+		nameTime += timer.nsecsElapsed();
+
+		timer.restart();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( int b = 0; b < blocks.count(); b++ ) {
+				for ( const NifFieldId & field : fields[b] )
+					sum += quintptr( nif.getIndex( blocks[b], field ).internalPointer() );
+			}
+		}
+		fieldTime += timer.nsecsElapsed();
+
+		timer.restart();
+		for ( int r = 0; r < repeats; r++ ) {
+			for ( int b = 0; b < blocks.count(); b++ ) {
+				for ( const QString & name : names[b] )
+					sum += quintptr( scan( blocks[b], name ) );
+			}
+		}
+		scanTime += timer.nsecsElapsed();
+	}
+
+	auto perLookup = [lookups]( qint64 nsecs ) {
+		return QString::number( lookups ? double( nsecs ) / double( lookups ) : 0.0, 'f', 1 );
+	};
+
+	out() << "files: " << files << ", lookups: " << lookups << ", mismatches: " << mismatches << endl;
+	out() << "by name:     " << msecs( nameTime ) << " ms, " << perLookup( nameTime ) << " ns per lookup" << endl;
+	out() << "by field ID: " << msecs( fieldTime ) << " ms, " << perLookup( fieldTime ) << " ns per lookup" << endl;
+	out() << "scan:        " << msecs( scanTime ) << " ms, " << perLookup( scanTime ) << " ns per lookup" << endl;
+	out() << "(checksum " << sum << ")" << endl;
+
+	return mismatches ? 1 : 0;
+}
+
+int Benchmark::archives( const QStringList & paths )
+{
+	const int maxFiles = 10000;
+
+	QVector<int> threadCounts;
+	for ( int t = 1; t < QThread::idealThreadCount(); t *= 2 )
+		threadCounts.append( t );
+	threadCounts.append( qMax( QThread::idealThreadCount(), 1 ) );
+
+	int failed = 0;
+
+	for ( const QString & path : findFiles( paths, { "*.bsa", "*.ba2" } ) ) {
+		auto handler = FSArchiveHandler::openArchive( path );
+		FSArchiveFile * archive = handler ? handler->getArchive() : nullptr;
+		if ( !archive ) {
+			out() << path << ": could not be opened" << endl;
+			failed++;
+			continue;
+		}
+
+		QStringList files = archive->fileList().mid( 0, maxFiles );
+		out() << path << ": " << files.count() << " files" << endl;
+
+		qint64 singleTime = 0;
+
+		for ( int threads : threadCounts ) {
+			// One slice per thread, each with its own counters
+			QVector<qint64> bytes( threads, 0 );
+			QVector<int> errors( threads, 0 );
+
+			QThreadPool pool;
+			pool.setMaxThreadCount( threads );
+
+			QElapsedTimer timer;
+			timer.start();
+
+			int slice = ( files.count() + threads - 1 ) / threads;
+			for ( int t = 0; t < threads; t++ )
+				pool.start( new ExtractTask( archive, files.mid( t * slice, slice ), bytes[t], errors[t] ) );
+
+			pool.waitForDone();
+			qint64 elapsed = timer.nsecsElapsed();
+
+			if ( threads == 1 )
+				singleTime = elapsed;
+
+			qint64 total = 0;
+			int errorCount = 0;
+			for ( int t = 0; t < threads; t++ ) {
+				total += bytes[t];
+				errorCount += errors[t];
+			}
+
+			failed += errorCount;
+
+			out() << "  " << threads << " threads: " << msecs( elapsed ) << " ms, "
+				<< QString::number( elapsed > 0 ? double( files.count() ) * 1e9 / double( elapsed ) : 0.0, 'f', 0 )
+				<< " files/s, " << throughput( total, elapsed ) << " MB/s, speedup "
+				<< QString::number( elapsed > 0 ? double( singleTime ) / double( elapsed ) : 0.0, 'f', 2 );
+			if ( errorCount )
+				out() << ", " << errorCount << " failed";
+			out() << endl;
+		}
+	}
+
+	return failed ? 1 : 0;
+}
+
+int Benchmark::textures( const QStringList & paths )
+{
+	// Textures with at least this much data have their chunks unpacked concurrently
+	const qint64 largeSize = 1 << 20;
+
+	qint64 smallBytes = 0, smallTime = 0, largeBytes = 0, largeTime = 0;
+	int archiveCount = 0, smallCount = 0, largeCount = 0, failed = 0;
+
+	for ( const QString & path : findFiles( paths, { "*.ba2" } ) ) {
+		auto handler = FSArchiveHandler::openArchive( path );
+		FSArchiveFile * archive = handler ? handler->getArchive() : nullptr;
+		if ( !archive ) {
+			out() << path << ": could not be opened" << endl;
+			failed++;
+			continue;
+		}
+
+		archiveCount++;
+
+		QByteArray data;
+		for ( const QString & file : archive->fileList() ) {
+			if ( !file.endsWith( ".dds" ) )
+				continue;
+
+			QElapsedTimer timer;
+			timer.start();
+			bool ok = archive->fileContents( file, data );
+			qint64 elapsed = timer.nsecsElapsed();
+
+			if ( !ok ) {
+				failed++;
+			} else if ( data.size() >= largeSize ) {
+				largeCount++;
+				largeBytes += data.size();
+				largeTime += elapsed;
+			} else {
+				smallCount++;
+				smallBytes += data.size();
+				smallTime += elapsed;
+			}
+		}
+	}
+
+	out() << "archives: " << archiveCount << ", textures: " << smallCount + largeCount
+		<< ", failed: " << failed << endl;
+	out() << "all:      " << QString::number( double( smallBytes + largeBytes ) / 1e6, 'f', 1 ) << " MB, "
+		<< throughput( smallBytes + largeBytes, smallTime + largeTime ) << " MB/s" << endl;
+	out() << "< 1 MiB:  " << smallCount << " textures, " << throughput( smallBytes, smallTime ) << " MB/s" << endl;
+	out() << ">= 1 MiB: " << largeCount << " textures, " << throughput( largeBytes, largeTime ) << " MB/s" << endl;
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2017, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+//! @file benchmark.h Benchmark
+
+class NifItem;
+
+/*! Timings of the load, evaluation and lookup paths, run from the command line
+ *
+ * Started with "NifSkope -no-gui -bench <name> [paths...]", where the paths are files or
+ * folders searched recursively. Each benchmark prints its timings to the standard output,
+ * so that runs before and after a change can be compared on the same corpus.
+ */
+class Benchmark final
+{
+public:
+	/*! Run a benchmark
+	 *
+	 * @param name	The name of the benchmark, or "help" to list them
+	 * @param paths	The files and folders to run it over
+	 * @return		The exit code of the application
+	 */
+	static int run( const QString & name, const QStringList & paths );
+
+private:
+	//! Evaluates the conditions of every field both as compiled bytecode and through the QVariant tree
+	static int expressions( const QStringList & paths );
+	//! Measures the items and bytes of the loaded files and getArray(), with arrays packed and with their rows created
+	static int memory( const QStringList & paths );
+	//! Measures the load throughput of NIF files
+	static int load( const QStringList & paths );
+	//! Measures the read throughput of fixed size arrays, in bulk against one value at a time
+	static int arrays( const QStringList & paths );
+	//! Measures parsing nif.xml and kfm.xml, without and with the schema cache
+	static int schema( const QStringList & paths );
+	//! Measures resizing a large array in place and the rows of its items
+	static int rows( const QStringList & paths );
+	//! Measures finding the fields of blocks by name, by field ID and by a scan of the children
+	static int lookup( const QStringList & paths );
+	//! Measures extracting files from BSA and BA2 archives with an increasing number of threads
+	static int archives( const QStringList & paths );
+	//! Measures the throughput of extracting the textures of BA2 archives
+	static int textures( const QStringList & paths );
+
+	//! Parse the XML description of the NIF format, or report why it failed
+	static bool loadSchema();
+	//! Finds an XML description next to the application or in the installed data
+	static QString schemaPath( const QString & name );
+	//! The files in @p paths that match @p filters, searching folders recursively
+	static QStringList findFiles( const QStringList & paths, const QStringList & filters );
+	//! Adds the items below @p parent that have a compiled condition
+	static void collectConditions( NifItem * parent, QVector<NifItem *> & items );
+	//! Adds the arrays below @p parent that are held in packed storage
+	static void collectPacked( NifItem * parent, QVector<NifItem *> & arrays );
+};
+
+#endif
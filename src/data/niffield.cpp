@@ -0,0 +1,174 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "niffield.h"
+
+#include <QAtomicPointer>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+
+//! @file niffield.cpp NifFieldId registry, NifStringPool
+
+//! A copy of the interned names which is never changed, read without a lock
+struct FrozenFields
+{
+	QHash<QString, int> ids;
+	QVector<QString> names;
+};
+
+//! The interned names
+struct FieldRegistry
+{
+	QReadWriteLock lock;
+	QHash<QString, int> ids;
+	QVector<QString> names;
+
+	//! The latest copy published by NifFieldId::freeze()
+	QAtomicPointer<const FrozenFields> frozen;
+	//! Every copy published, kept since readers may still hold an earlier one
+	std::vector<std::unique_ptr<const FrozenFields>> copies;
+};
+
+//! Function local so that static NifFieldIds in other units are safe to construct
+static FieldRegistry & registry()
+{
+	static FieldRegistry r;
+	return r;
+}
+
+int NifFieldId::intern( const QString & name )
+{
+	FieldRegistry & r = registry();
+
+	{
+		QReadLocker lck( &r.lock );
+
+		auto it = r.ids.constFind( name );
+		if ( it != r.ids.constEnd() )
+			return it.value();
+	}
+
+	QWriteLocker lck( &r.lock );
+
+	// Interned by another thread in the meantime
+	auto it = r.ids.constFind( name );
+	if ( it != r.ids.constEnd() )
+		return it.value();
+
+	int id = r.names.count();
+	r.names.append( name );
+	r.ids.insert( name, id );
+
+	return id;
+}
+
+NifFieldId NifFieldId::find( const QString & name )
+{
+	FieldRegistry & r = registry();
+	NifFieldId f;
+
+	// Names of the schema are in the frozen copy; only names interned after it take the lock
+	if ( const FrozenFields * frozen = r.frozen.loadAcquire() ) {
+		f.id = frozen->ids.value( name, -1 );
+		if ( f.id >= 0 )
+			return f;
+	}
+
+	QReadLocker lck( &r.lock );
+
+	f.id = r.ids.value( name, -1 );
+	return f;
+}
+
+QString NifFieldId::name() const
+{
+	FieldRegistry & r = registry();
+
+	if ( const FrozenFields * frozen = r.frozen.loadAcquire() ) {
+		if ( id >= 0 && id < frozen->names.count() )
+			return frozen->names.at( id );
+	}
+
+	QReadLocker lck( &r.lock );
+
+	return r.names.value( id );
+}
+
+void NifFieldId::freeze()
+{
+	FieldRegistry & r = registry();
+	QWriteLocker lck( &r.lock );
+
+	auto frozen = new FrozenFields{ r.ids, r.names };
+	r.copies.emplace_back( frozen );
+	r.frozen.storeRelease( frozen );
+}
+
+//! The pooled strings
+struct StringPool
+{
+	QReadWriteLock lock;
+	QSet<QString> strings;
+};
+
+//! Function local for the same reason as registry()
+static StringPool & pool()
+{
+	static StringPool p;
+	return p;
+}
+
+QString NifStringPool::intern( const QString & str )
+{
+	if ( str.isEmpty() )
+		return QString();
+
+	StringPool & p = pool();
+
+	{
+		QReadLocker lck( &p.lock );
+
+		auto it = p.strings.constFind( str );
+		if ( it != p.strings.constEnd() )
+			return *it;
+	}
+
+	QWriteLocker lck( &p.lock );
+
+	return *p.strings.insert( str );
+}
@@ -0,0 +1,101 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef NIFFIELD_H
+#define NIFFIELD_H
+
+#include <QString>
+
+
+//! @file niffield.h NifFieldId, NifStringPool
+
+/*! An interned field name.
+ *
+ * Every name in the XML is given a stable integer ID the first time it is seen so that
+ * items can be found with integer compares and the row tables of their compound or block
+ * instead of string scans. IDs are never recycled, which makes it safe to keep a
+ * NifFieldId in a static:
+ *
+ * @code
+ * static const NifFieldId fieldVertices( "Vertices" );
+ * auto verts = nif->getArray<Vector3>( iData, fieldVertices );
+ * @endcode
+ */
+class NifFieldId final
+{
+public:
+	NifFieldId() {}
+
+	//! Interns a field name
+	explicit NifFieldId( const QString & name )
+		: id( intern( name ) ) {}
+
+	//! Get the integer ID, -1 if invalid
+	inline int value() const { return id; }
+	//! Is the ID valid
+	inline bool isValid() const { return id >= 0; }
+	//! Get the field name of the ID
+	QString name() const;
+
+	inline bool operator==( const NifFieldId & other ) const { return id == other.id; }
+	inline bool operator!=( const NifFieldId & other ) const { return id != other.id; }
+
+	//! Get the ID of a field name without interning it; invalid if the name was never seen
+	static NifFieldId find( const QString & name );
+
+	/*! Publish the names interned so far for lookups without a lock.
+	 *
+	 * Called once the schema is loaded. Names interned later are still found, with a lock,
+	 * until the next call.
+	 */
+	static void freeze();
+
+private:
+	//! Get the ID of a field name, interning it if necessary
+	static int intern( const QString & name );
+
+	int id = -1;
+};
+
+/*! A pool of the strings of the XML.
+ *
+ * Names, types and attributes repeat across thousands of fields; interning them makes
+ * every NifSharedData with the same string share one buffer. Strings are never removed.
+ */
+class NifStringPool final
+{
+public:
+	//! Get the pooled copy of a string, adding it to the pool if necessary
+	static QString intern( const QString & str );
+};
+
+#endif
@@ -33,16 +33,39 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef NIFITEM_H
 #define NIFITEM_H
 
+#include "data/niffield.h"
+#include "data/nifitempool.h"
 #include "data/nifvalue.h"
 #include "xml/nifexpr.h"
 
 #include <QSharedData> // Inherited
+#include <QHash>
 #include <QPointer>
 #include <QString>
 #include <QVector>
 
+#include <memory>
 
-//! @file nifitem.h NifItem, NifBlock, NifData, NifSharedData
+
+//! @file nifitem.h NifItem, NifItemLoader, NifBlock, NifData, NifSharedData, NifFieldRows
+
+class NifItem;
+
+/*! Rows of the fields of a compound or block, by field ID.
+ *
+ * Built once from the XML; every instance of the type has its fields at these rows.
+ */
+struct NifFieldRows
+{
+	//! Rows of each field ID in schema order; names repeat across versions
+	QHash<int, QVector<int>> rows;
+	//! Number of rows in an instance of the type
+	int count = 0;
+	//! Rows whose condition reads each field ID, by the field ID
+	QHash<int, QVector<int>> dependents;
+	//! Rows whose argument reads each field ID, by the field ID; the conditions of their children depend on it
+	QHash<int, QVector<int>> argDependents;
+};
 
 /*! Shared data for NifData.
  *
@@ -51,6 +74,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 class NifSharedData final : public QSharedData
 {
 	friend class NifData;
+	friend QDataStream & operator<<( QDataStream & ds, const NifData & data );
+	friend QDataStream & operator>>( QDataStream & ds, NifData & data );
 
 public:
 	enum DataFlag
@@ -72,22 +97,28 @@ private:
 
 	NifSharedData( const QString & n, const QString & t, const QString & tt, const QString & a, const QString & a1,
 				   const QString & a2, const QString & c, quint32 v1, quint32 v2, NifSharedData::DataFlags f )
-		: QSharedData(), name( n ), type( t ), temp( tt ), arg( a ), arr1( a1 ), arr2( a2 ),
-		cond( c ), ver1( v1 ), ver2( v2 ), condexpr( c ), arr1expr( a1 ), flags( f )
+		: QSharedData(), name( pooled( n ) ), nameId( n ), type( pooled( t ) ), temp( pooled( tt ) ), arg( pooled( a ) ),
+		arr1( pooled( a1 ) ), arr2( pooled( a2 ) ), cond( pooled( c ) ), ver1( v1 ), ver2( v2 ), condexpr( c ), arr1expr( a1 ),
+		flags( f )
 	{
 	}
 
 	NifSharedData( const QString & n, const QString & t )
-		: QSharedData(), name( n ), type( t ) {}
+		: QSharedData(), name( pooled( n ) ), nameId( n ), type( pooled( t ) ) {}
 
 	NifSharedData( const QString & n, const QString & t, const QString & txt )
-		: QSharedData(), name( n ), type( t ), text( txt ) {}
+		: QSharedData(), name( pooled( n ) ), nameId( n ), type( pooled( t ) ), text( txt ) {}
 
 	NifSharedData()
 		: QSharedData() {}
 
+	//! Get the copy of a schema string from NifStringPool
+	static inline QString pooled( const QString & str ) { return NifStringPool::intern( str ); }
+
 	//! Name.
 	QString name;
+	//! Interned name.
+	NifFieldId nameId;
 	//! Type.
 	QString type;
 	//! Template type.
@@ -114,6 +145,10 @@ private:
 	QString vercond;
 	//! Version condition as an expression.
 	NifExpr verexpr;
+	//! Number of the version condition among the distinct ones of the XML, -1 if not numbered
+	int vercondId = -1;
+	//! Row table of the compound type, if any.
+	std::shared_ptr<const NifFieldRows> fieldRows;
 
 	DataFlags flags = None;
 };
@@ -123,6 +158,9 @@ Q_DECLARE_OPERATORS_FOR_FLAGS( NifSharedData::DataFlags );
 //! The data and NifValue stored by a NifItem
 class NifData
 {
+	friend QDataStream & operator<<( QDataStream & ds, const NifData & data );
+	friend QDataStream & operator>>( QDataStream & ds, NifData & data );
+
 public:
 	NifData( const QString & name, const QString & type, const QString & temp, const NifValue & val, const QString & arg,
 			 const QString & arr1 = QString(), const QString & arr2 = QString(), const QString & cond = QString(),
@@ -138,6 +176,8 @@ public:
 
 	//! Get the name of the data.
 	inline const QString & name() const { return d->name; }
+	//! Get the interned name of the data.
+	inline const NifFieldId & nameId() const { return d->nameId; }
 	//! Get the type of the data.
 	inline const QString & type() const { return d->type; }
 	//! Get the template type of the data.
@@ -164,6 +204,12 @@ public:
 	inline const QString & vercond() const { return d->vercond; }
 	//! Get the version condition attribute of the data, as an expression.
 	inline const NifExpr & verexpr() const { return d->verexpr; }
+	//! Get the number of the version condition of the data, see NifModel::versionConditions.
+	inline int vercondId() const { return d->vercondId; }
+	//! Get the row table of the compound type of the data.
+	inline const std::shared_ptr<const NifFieldRows> & fieldRows() const { return d->fieldRows; }
+	//! Get the shared data, which identifies data copied from the same field.
+	inline const NifSharedData * shared() const { return d.constData(); }
 	//! Get the abstract attribute of the data.
 	inline bool isAbstract() const { return d->flags & NifSharedData::Abstract; }
 	//! Is the data binary. Binary means the data is being treated as one blob.
@@ -182,25 +228,29 @@ public:
 	inline bool isMixin() const { return d->flags & NifSharedData::Mixin; }
 
 	//! Sets the name of the data.
-	void setName( const QString & name ) { d->name = name; }
+	void setName( const QString & name )
+	{
+		d->name = NifSharedData::pooled( name );
+		d->nameId = NifFieldId( name );
+	}
 	//! Sets the type of the data.
-	void setType( const QString & type ) { d->type = type; }
+	void setType( const QString & type ) { d->type = NifSharedData::pooled( type ); }
 	//! Sets the template type of the data.
-	void setTemp( const QString & temp ) { d->temp = temp; }
+	void setTemp( const QString & temp ) { d->temp = NifSharedData::pooled( temp ); }
 	//! Sets the argument of the data.
-	void setArg( const QString & arg ) { d->arg = arg; }
+	void setArg( const QString & arg ) { d->arg = NifSharedData::pooled( arg ); }
 	//! Sets the first array length of the data.
 	void setArr1( const QString & arr1 )
 	{
-		d->arr1 = arr1;
+		d->arr1 = NifSharedData::pooled( arr1 );
 		d->arr1expr = NifExpr( arr1 );
 	}
 	//! Sets the second array length of the data.
-	void setArr2( const QString & arr2 ) { d->arr2 = arr2; }
+	void setArr2( const QString & arr2 ) { d->arr2 = NifSharedData::pooled( arr2 ); }
 	//! Sets the condition attribute of the data.
 	void setCond( const QString & cond )
 	{
-		d->cond = cond;
+		d->cond = NifSharedData::pooled( cond );
 		d->condexpr = NifExpr( cond );
 	}
 	//! Sets the earliest version of the data.
@@ -212,9 +262,14 @@ public:
 	//! Sets the version condition attribute of the data.
 	void setVerCond( const QString & cond )
 	{
-		d->vercond = cond;
+		d->vercond = NifSharedData::pooled( cond );
 		d->verexpr = NifExpr( cond );
+		d->vercondId = -1;
 	}
+	//! Sets the number of the version condition of the data.
+	void setVercondId( int id ) { d->vercondId = id; }
+	//! Sets the row table of the compound type of the data.
+	void setFieldRows( const std::shared_ptr<const NifFieldRows> & rows ) { d->fieldRows = rows; }
 
 	inline void setFlag( NifSharedData::DataFlags flag, bool val )
 	{
@@ -259,6 +314,25 @@ struct NifBlock
 	bool abstract = false;
 	//! Data present.
 	QList<NifData> types;
+	//! Rows of the fields in an instance, including ancestors and mixins.
+	std::shared_ptr<NifFieldRows> fieldRows;
+	//! Data of the items of blocks of this type, shared by all of them.
+	NifData data;
+};
+
+/*! Creates the child items of a NifItem when they are first accessed.
+ *
+ * @see NifItem::setLoader()
+ */
+class NifItemLoader
+{
+public:
+	virtual ~NifItemLoader() {}
+
+	//! Create the child items of the item
+	virtual void load( NifItem * item ) = 0;
+	//! Copy any data which refers to memory owned elsewhere, e.g. a memory mapped file
+	virtual void detach() {}
 };
 
 //! An item which contains NifData
@@ -276,6 +350,30 @@ public:
 		qDeleteAll( childItems );
 	}
 
+	//! Allocates an item from the heap
+	static void * operator new( std::size_t size ) { return NifItemPool::allocate( nullptr, size ); }
+	//! Allocates an item from a pool, or from the heap if the pool is null
+	static void * operator new( std::size_t size, NifItemPool * pool ) { return NifItemPool::allocate( pool, size ); }
+	//! Releases an item to wherever it was allocated from
+	static void operator delete( void * ptr ) { NifItemPool::release( ptr ); }
+	static void operator delete( void * ptr, NifItemPool * ) { NifItemPool::release( ptr ); }
+
+	//! Get the pool the item was allocated from; its children are allocated from it too
+	inline NifItemPool * pool() const { return NifItemPool::owner( this ); }
+
+	//! Values of an array of fixed size elements, kept contiguous until their rows are needed
+	struct PackedArray
+	{
+		//! The data each element row is created from
+		NifData element;
+		//! The element values, written by NifValue::toPacked()
+		QByteArray data;
+		//! The number of elements
+		int count = 0;
+		//! The size of one element in bytes
+		int size = 0;
+	};
+
 	//! Return the parent item.
 	NifItem * parent() const
 	{
@@ -288,6 +386,7 @@ public:
 		if ( !parentItem )
 			return 0;
 
+		// Kept up to date by the parent as children are inserted and removed
 		if ( rowIdx < 0 )
 			rowIdx = parentItem->childItems.indexOf( const_cast<NifItem *>(this) );
 
@@ -306,9 +405,114 @@ public:
 	//! Get child items
 	const QVector<NifItem *> & children()
 	{
+		materialize();
 		return childItems;
 	}
 
+	//! Is the array held in packed storage instead of child items
+	bool isPacked() const
+	{
+		return packed != nullptr;
+	}
+
+	//! The packed storage of the array, or nullptr if it has child items
+	PackedArray * packedArray() const
+	{
+		return packed.get();
+	}
+
+	/*! Resize the packed storage of an array
+	 *
+	 * New elements take the value of the element data.
+	 *
+	 * @param count		The new number of elements
+	 * @param element	The data for the elements of the array
+	 * @return			False if the item has child items or the type cannot be packed
+	 */
+	bool resizePacked( int count, const NifData & element )
+	{
+		int size = NifValue::packedSize( element.value.type() );
+		if ( size == 0 || !childItems.isEmpty() )
+			return false;
+
+		if ( !packed ) {
+			packed.reset( new PackedArray );
+			packed->element = element;
+			packed->size = size;
+		} else if ( packed->size != size ) {
+			return false;
+		}
+
+		int prev = packed->count;
+		packed->data.resize( count * size );
+		packed->count = count;
+
+		if ( count > prev ) {
+			char * dst = packed->data.data();
+			element.value.toPacked( dst + prev * size );
+			for ( int i = prev + 1; i < count; i++ )
+				memcpy( dst + i * size, dst + prev * size, size );
+		}
+
+		return true;
+	}
+
+	//! Return the value of an element in packed storage
+	NifValue packedValue( int row ) const
+	{
+		NifValue v( packed->element.value.type() );
+		if ( row >= 0 && row < packed->count )
+			v.fromPacked( packed->data.constData() + row * packed->size );
+		return v;
+	}
+
+	//! Is the creation of the child items deferred to a loader
+	bool isDeferred() const
+	{
+		return loader != nullptr;
+	}
+
+	//! The loader the child items are deferred to, or nullptr
+	NifItemLoader * deferredLoader() const
+	{
+		return loader.get();
+	}
+
+	//! Defer the creation of the child items until they are first accessed; takes ownership
+	void setLoader( NifItemLoader * l )
+	{
+		loader.reset( l );
+	}
+
+	/*! Create the child items of a deferred item or of an array in packed storage
+	 *
+	 * Called before any access to the child items, so that the rows only exist
+	 * once something needs to address them.
+	 */
+	void materialize() const
+	{
+		if ( loader ) {
+			// Released first, as loading accesses the child items
+			std::unique_ptr<NifItemLoader> l( std::move( loader ) );
+			l->load( const_cast<NifItem *>( this ) );
+		}
+
+		if ( !packed )
+			return;
+
+		std::unique_ptr<PackedArray> p( std::move( packed ) );
+		auto self = const_cast<NifItem *>( this );
+
+		childItems.reserve( p->count );
+		for ( int i = 0; i < p->count; i++ ) {
+			NifItem * item = new ( pool() ) NifItem( p->element, self );
+			item->itemData.value.fromPacked( p->data.constData() + i * p->size );
+			item->setCondition( true );
+			item->rowIdx = i;
+			childItems.append( item );
+		}
+	}
+
 	/*! Insert child data item
 	 *
 	 * @param data	The data to insert
@@ -317,17 +521,19 @@ public:
 	 */
 	NifItem * insertChild( const NifData & data, int at = -1 )
 	{
-		NifItem * item = new NifItem( data, this );
+		materialize();
+
+		NifItem * item = new ( pool() ) NifItem( data, this );
 
 		if ( data.isConditionless() )
 			item->setCondition( true );
 
 		if ( at < 0 || at > childItems.count() ) {
+			item->rowIdx = childItems.count();
 			childItems.append( item );
 		} else {
-			if ( at < childItems.size() - 1 )
-				invalidateRowCounts();
 			childItems.insert( at, item );
+			renumberRows( at );
 		}
 
 		populateLinksUp( item );
@@ -343,13 +549,16 @@ public:
 	 */
 	int insertChild( NifItem * child, int at = -1 )
 	{
+		materialize();
+
 		child->parentItem = this;
 
 		if ( at < 0 || at > childItems.count() ) {
+			child->rowIdx = childItems.count();
 			childItems.append( child );
 		} else {
-			invalidateRowCounts();
 			childItems.insert( at, child );
+			renumberRows( at );
 		}
 
 		populateLinksUp( child );
@@ -357,20 +566,49 @@ public:
 		return child->row();
 	}
 
+	/*! Append copies of the children of another item, along with its row caches
+	 *
+	 * The evaluated conditions are copied too, so the other item should not have packed or deferred rows.
+	 *
+	 * @param other	The item to copy the children of
+	 */
+	void cloneChildren( const NifItem * other )
+	{
+		if ( other->caches )
+			caches.reset( new RowCaches( *other->caches ) );
+
+		childItems.reserve( childItems.count() + other->childItems.count() );
+
+		for ( const NifItem * c : other->childItems ) {
+			NifItem * item = new ( pool() ) NifItem( c->itemData, this );
+			item->rowIdx = childItems.count();
+			item->conditionStatus = c->conditionStatus;
+			item->vercondStatus = c->vercondStatus;
+			childItems.append( item );
+
+			item->cloneChildren( c );
+		}
+	}
+
+	//! The number of children above which child() looks up the row table instead of comparing every child
+	static constexpr int hashedLookupRows = 8;
+
 	//! Inform the parent and its ancestors of any links
 	void populateLinksUp( NifItem * item )
 	{
 		if ( item->value().type() == NifValue::tLink || item->value().type() == NifValue::tUpLink ) {
 			// Add this child's row to the item's link vector
-			linkRows << item->row();
+			rowCaches().linkRows << item->row();
 	
 			// Inform the parent that this item's rows have links
+			//	The root is left out, so that blocks can be loaded concurrently
 			auto p = parentItem;
 			auto c = this;
-			while ( p ) {
+			while ( p && p->parentItem ) {
 				// Add this item's row to the parent item
-				if ( !p->linkAncestorRows.contains( c->row() ) )
-					p->linkAncestorRows << c->row();
+				QVector<ushort> & ancestorRows = p->rowCaches().linkAncestorRows;
+				if ( !ancestorRows.contains( c->row() ) )
+					ancestorRows << c->row();
 	
 				// Recurse up
 				c = p;
@@ -386,11 +624,14 @@ public:
 	 */
 	NifItem * takeChild( int row )
 	{
+		materialize();
+
 		NifItem * item = child( row );
-		invalidateRowCounts();
 		if ( item ) {
 			childItems.remove( row );
+			renumberRows( row );
 			item->parentItem = 0;
+			item->rowIdx = -1;
 		}
 
 		return item;
@@ -402,10 +643,12 @@ public:
 	 */
 	void removeChild( int row )
 	{
+		materialize();
+
 		NifItem * item = child( row );
-		invalidateRowCounts();
 		if ( item ) {
 			childItems.remove( row );
+			renumberRows( row );
 			delete item;
 		}
 	}
@@ -417,7 +660,7 @@ public:
 	 */
 	void removeChildren( int row, int count )
 	{
-		invalidateRowCounts();
+		materialize();
 		for ( int c = row; c < row + count; c++ ) {
 			NifItem * item = childItems.value( c );
 			if ( item )
@@ -425,83 +668,160 @@ public:
 		}
 
 		childItems.remove( row, count );
+		renumberRows( row );
 	}
 
 	//! Return the child item at the specified row
 	NifItem * child( int row )
 	{
+		materialize();
 		return childItems.value( row );
 	}
 
 	//! Return the child item at the specified row
 	const NifItem * child( int row ) const
 	{
+		materialize();
 		return childItems.value( row );
 	}
 
 	//! Return the child item with the specified name
 	NifItem * child( const QString & name )
 	{
-		for ( NifItem * child : childItems ) {
-			if ( child->name() == name )
-				return child;
-		}
-		return nullptr;
+		// Every item name is interned, so an unknown name has no child
+		NifFieldId field = NifFieldId::find( name );
+		if ( !field.isValid() )
+			return nullptr;
+
+		return child( field, []( NifItem * ) { return true; } );
 	}
 
 	//! Return the child item with the specified name
 	const NifItem * child( const QString & name ) const
 	{
-		for ( const NifItem * child : childItems ) {
-			if ( child->name() == name )
-				return child;
+		return const_cast<NifItem *>( this )->child( name );
+	}
+
+	/*! Return the first child item with the specified field ID that is accepted by a predicate
+	 *
+	 * Looks up the candidate rows in the row table of the item's compound or block
+	 * when it has more than hashedLookupRows children, and otherwise or if the table
+	 * does not fit the children compares the ID of every child.
+	 *
+	 * @param field	The interned name to find
+	 * @param pred	Called with each candidate NifItem *, e.g. to evaluate conditions
+	 */
+	template <typename F> NifItem * child( const NifFieldId & field, const F & pred )
+	{
+		materialize();
+
+		const NifFieldRows * table = isArray() ? nullptr : fieldRows().get();
+
+		if ( table && childItems.count() > hashedLookupRows && table->count == childItems.count() ) {
+			auto it = table->rows.constFind( field.value() );
+			if ( it == table->rows.constEnd() )
+				return nullptr;
+
+			bool valid = true;
+			for ( int r : it.value() ) {
+				NifItem * c = childItems.at( r );
+
+				if ( c->nameId() != field ) {
+					valid = false;
+					break;
+				}
+
+				if ( pred( c ) )
+					return c;
+			}
+
+			if ( valid )
+				return nullptr;
 		}
+
+		for ( NifItem * c : childItems ) {
+			if ( c->nameId() == field && pred( c ) )
+				return c;
+		}
+
 		return nullptr;
 	}
 
 	//! Return a count of the number of child items
 	int childCount() const
 	{
+		if ( loader )
+			materialize();
+
+		if ( packed )
+			return packed->count;
+
 		return childItems.count();
 	}
 
 	//! Remove all child items
 	void killChildren()
 	{
+		loader.reset();
+		packed.reset();
 		qDeleteAll( childItems );
 		childItems.clear();
 	}
 
+	/*! Add up the memory used by the item and its descendants, without creating deferred or packed rows
+	 *
+	 * @param items	Incremented by the number of items
+	 * @param bytes	Incremented by the size of the items and of the heap blocks they own, excluding strings and byte arrays
+	 */
+	void memoryUsage( qint64 & items, qint64 & bytes ) const
+	{
+		items++;
+		bytes += sizeof( NifItem ) + itemData.value.heapSize() + childItems.capacity() * sizeof( NifItem * );
+
+		if ( caches ) {
+			bytes += sizeof( RowCaches ) + caches->arrConds.capacity() * sizeof( bool )
+				+ ( caches->linkAncestorRows.capacity() + caches->linkRows.capacity() ) * sizeof( ushort );
+		}
+
+		if ( packed )
+			bytes += sizeof( PackedArray ) + packed->data.capacity();
+
+		for ( const NifItem * child : childItems )
+			child->memoryUsage( items, bytes );
+	}
+
 	const QVector<ushort> & getLinkAncestorRows() const
 	{
-		return linkAncestorRows;
+		materialize();
+		return caches ? caches->linkAncestorRows : none<ushort>();
 	}
 	
 	const QVector<ushort> & getLinkRows() const
 	{
-		return linkRows;
+		materialize();
+		return caches ? caches->linkRows : none<ushort>();
 	}
 
 	//! Conditions for each child in the array (if fixed)
 	const QVector<bool> & arrayConditions()
 	{
-		return arrConds;
+		return caches ? caches->arrConds : none<bool>();
 	}
 
 	//! Reset array conditions based on size of children
 	void resetArrayConditions()
 	{
+		materialize();
 		if ( childItems.isEmpty() )
 			return;
 
-		arrConds.clear();
-		arrConds.resize( childItems.at( 0 )->childCount() );
-		arrConds.fill( false );
+		resetArrayConditions( childItems.at( 0 )->childCount() );
 	}
 
 	//! Reset array conditions based on provided size
 	void resetArrayConditions( int size )
 	{
+		QVector<bool> & arrConds = rowCaches().arrConds;
 		arrConds.clear();
 		arrConds.resize( size );
 		arrConds.fill( false );
@@ -510,8 +830,8 @@ public:
 	//! Update array condition at specified index
 	void updateArrayCondition( bool cond, int at )
 	{
-		if ( arrConds.count() > at )
-			arrConds[at] = cond;
+		if ( caches && caches->arrConds.count() > at )
+			caches->arrConds[at] = cond;
 	}
 
 	//! Cached result of cond expression
@@ -562,33 +882,15 @@ public:
 		vercondStatus = -1;
 	}
 
-	//! Invalidate the cached row index
-	void invalidateRow()
-	{
-		rowIdx = -1;
-	}
-
-	//! Invalidate the cached row index for this item and its children
-	void invalidateRowCounts()
-	{
-		invalidateRow();
-		for ( NifItem * c : childItems ) {
-			c->invalidateRow();
-		}
-	}
-
-	//! Invalidate the cached row index for this item and its children starting at the given index
-	void invalidateRowCounts( int at )
+	/*! Update the row indices of the children from a row on
+	 *
+	 * The rows before it are unaffected by an insert or removal there, so only the
+	 * suffix which QVector moved anyway is renumbered.
+	 */
+	void renumberRows( int from )
 	{
-		if ( at < childCount() ) {
-			invalidateRow();
-			for ( int i = at; i < childCount(); i++ ) {
-				childItems.value( i )->invalidateRow();
-			}
-		} else {
-			invalidateRowCounts();
-		}
-
+		for ( int i = qMax( from, 0 ); i < childItems.count(); i++ )
+			childItems.at( i )->rowIdx = i;
 	}
 
 	//! Return the value of the item data (const version)
@@ -598,6 +900,12 @@ public:
 
 	//! Return the name of the data
 	inline QString name() const {   return itemData.name(); }
+	//! Return the interned name of the data
+	inline const NifFieldId & nameId() const { return itemData.nameId(); }
+	//! Return the row table of the compound or block of the data
+	inline const std::shared_ptr<const NifFieldRows> & fieldRows() const { return itemData.fieldRows(); }
+	//! Get the data of the item, which excludes its children.
+	inline const NifData & data() const { return itemData; }
 	//! Return the type of the data
 	inline QString type() const {   return itemData.type(); }
 	//! Return the template type of the data
@@ -625,6 +933,8 @@ public:
 	inline QString vercond() const {   return itemData.vercond();  }
 	//! Return the version condition attribute of the data, as an expression
 	inline const NifExpr & verexpr() const {   return itemData.verexpr();  }
+	//! Return the number of the version condition of the item data
+	inline int vercondId() const {   return itemData.vercondId();  }
 	//! Return the abstract attribute of the data
 	inline bool isAbstract() const { return itemData.isAbstract(); }
 	//! Is the item data binary. Binary means the data is being treated as one blob.
@@ -664,6 +974,8 @@ public:
 	inline void setText( const QString & text )    {   itemData.setText( text );    }
 	//! Set the version condition attribute
 	inline void setVerCond( const QString & cond ) {   itemData.setVerCond( cond ); }
+	//! Set the row table of the compound or block
+	inline void setFieldRows( const std::shared_ptr<const NifFieldRows> & rows ) { itemData.setFieldRows( rows ); }
 
 	//! Determine if this item is present in the specified version
 	inline bool evalVersion( quint32 v )
@@ -675,6 +987,16 @@ public:
 	template <typename T> QVector<T> getArray() const
 	{
 		QVector<T> array;
+		if ( packed ) {
+			array.reserve( packed->count );
+			NifValue v( packed->element.value.type() );
+			for ( int i = 0; i < packed->count; i++ ) {
+				v.fromPacked( packed->data.constData() + i * packed->size );
+				array.append( v.get<T>() );
+			}
+			return array;
+		}
+
 		for ( NifItem * child : childItems ) {
 			array.append( child->itemData.value.get<T>() );
 		}
@@ -684,6 +1006,15 @@ public:
 	//! Set the child items from an array
 	template <typename T> void setArray( const QVector<T> & array )
 	{
+		if ( packed ) {
+			NifValue v( packed->element.value.type() );
+			for ( int i = 0; i < packed->count; i++ ) {
+				if ( v.set<T>( array.value( i ) ) )
+					v.toPacked( packed->data.data() + i * packed->size );
+			}
+			return;
+		}
+
 		int x = 0;
 		for ( NifItem * child : childItems ) {
 			child->itemData.value.set<T>( array.value( x++ ) );
@@ -693,6 +1024,15 @@ public:
 	//! Set the child items from a single value
 	template <typename T> void setArray( const T & val )
 	{
+		if ( packed ) {
+			NifValue v( packed->element.value.type() );
+			if ( v.set<T>( val ) ) {
+				for ( int i = 0; i < packed->count; i++ )
+					v.toPacked( packed->data.data() + i * packed->size );
+			}
+			return;
+		}
+
 		for ( NifItem * child : childItems ) {
 			child->itemData.value.set<T>( val );
 		}
@@ -704,14 +1044,38 @@ private:
 	//! The parent of this item
 	NifItem * parentItem = nullptr;
 	//! The child items
-	QVector<NifItem *> childItems;
-
-	//! Rows which have links under them at any level
-	QVector<ushort> linkAncestorRows;
-	//! Rows which are links
-	QVector<ushort> linkRows;
-	//! If item is array with fixed compounds, the conditions are stored here for reuse
-	QVector<bool> arrConds;
+	mutable QVector<NifItem *> childItems;
+	//! The array values while no child items exist, see materialize()
+	mutable std::unique_ptr<PackedArray> packed;
+	//! Creates the child items on first access, see materialize()
+	mutable std::unique_ptr<NifItemLoader> loader;
+
+	//! Row caches, only allocated on the items which have links below them or fixed array conditions
+	struct RowCaches
+	{
+		//! Rows which have links under them at any level
+		QVector<ushort> linkAncestorRows;
+		//! Rows which are links
+		QVector<ushort> linkRows;
+		//! If item is array with fixed compounds, the conditions are stored here for reuse
+		QVector<bool> arrConds;
+	};
+	std::unique_ptr<RowCaches> caches;
+
+	//! Get the row caches, allocating them if necessary
+	RowCaches & rowCaches()
+	{
+		if ( !caches )
+			caches.reset( new RowCaches );
+		return *caches;
+	}
+
+	//! The rows of an item without row caches
+	template <typename T> static const QVector<T> & none()
+	{
+		static const QVector<T> rows;
+		return rows;
+	}
 
 	//! Item's row index, -1 is invalid, otherwise 0+
 	mutable int rowIdx = -1;
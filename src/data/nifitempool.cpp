@@ -0,0 +1,130 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "nifitempool.h"
+
+#include <QSettings>
+
+
+//! @file nifitempool.cpp NifItemPool
+
+NifItemPool::NifItemPool( std::size_t size )
+	: blockSize( HeaderSize + ( size + HeaderSize - 1 ) / HeaderSize * HeaderSize )
+{
+}
+
+void * NifItemPool::allocate( NifItemPool * pool, std::size_t size )
+{
+	char * block;
+
+	if ( !pool ) {
+		block = static_cast<char *>( ::operator new( HeaderSize + size ) );
+	} else {
+		Q_ASSERT( HeaderSize + size <= pool->blockSize );
+
+		QMutexLocker lck( &pool->lock );
+
+		if ( pool->freeList ) {
+			block = static_cast<char *>( pool->freeList );
+			pool->freeList = *reinterpret_cast<void **>( block );
+		} else {
+			if ( pool->chunkUsed == ChunkBlocks ) {
+				pool->chunks.emplace_back( new char[ChunkBlocks * pool->blockSize] );
+				pool->chunkUsed = 0;
+			}
+
+			block = pool->chunks.back().get() + pool->chunkUsed * pool->blockSize;
+			pool->chunkUsed++;
+		}
+
+		pool->live++;
+	}
+
+	*reinterpret_cast<NifItemPool **>( block ) = pool;
+
+	return block + HeaderSize;
+}
+
+void NifItemPool::release( void * ptr )
+{
+	if ( !ptr )
+		return;
+
+	char * block = static_cast<char *>( ptr ) - HeaderSize;
+	NifItemPool * pool = *reinterpret_cast<NifItemPool **>( block );
+
+	if ( !pool ) {
+		::operator delete( block );
+		return;
+	}
+
+	bool done;
+
+	{
+		QMutexLocker lck( &pool->lock );
+
+		*reinterpret_cast<void **>( block ) = pool->freeList;
+		pool->freeList = block;
+		pool->live--;
+
+		done = pool->orphaned && pool->live == 0;
+	}
+
+	if ( done )
+		delete pool;
+}
+
+NifItemPool * NifItemPool::owner( const void * ptr )
+{
+	return *reinterpret_cast<NifItemPool * const *>( static_cast<const char *>( ptr ) - HeaderSize );
+}
+
+void NifItemPool::orphan()
+{
+	bool done;
+
+	{
+		QMutexLocker lck( &lock );
+
+		orphaned = true;
+		done = ( live == 0 );
+	}
+
+	if ( done )
+		delete this;
+}
+
+bool NifItemPool::isEnabled()
+{
+	QSettings settings;
+	return settings.value( "Pool Items", true ).toBool();
+}
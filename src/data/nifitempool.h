@@ -0,0 +1,98 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef NIFITEMPOOL_H
+#define NIFITEMPOOL_H
+
+#include <QMutex>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+//! @file nifitempool.h NifItemPool
+
+/*! Fixed size memory for the NifItems of one model.
+ *
+ * Items are carved from large chunks and released items are kept for reuse, so loading and
+ * clearing a model repeatedly costs no heap calls for the items once the chunks exist.
+ * Every allocation is preceded by the pool it came from, which lets items moved to
+ * another model be released to the pool they were allocated from. A pool whose model is
+ * gone is freed with the last of its items.
+ *
+ * @see NifItem::operator new()
+ */
+class NifItemPool final
+{
+public:
+	//! Creates a pool of blocks of @p size bytes
+	explicit NifItemPool( std::size_t size );
+
+	//! Allocates memory from @p pool, or from the heap if it is null
+	static void * allocate( NifItemPool * pool, std::size_t size );
+	//! Releases memory to the pool it was allocated from
+	static void release( void * ptr );
+	//! Get the pool memory was allocated from, null if from the heap
+	static NifItemPool * owner( const void * ptr );
+
+	//! Give up the pool; it is freed now or when the last item allocated from it is released
+	void orphan();
+
+	//! Are items of new models allocated from a pool, or one at a time from the heap
+	static bool isEnabled();
+
+private:
+	~NifItemPool() = default;
+
+	//! Size of the header before each allocation; keeps the allocation pointer aligned
+	static const std::size_t HeaderSize = sizeof( void * );
+	//! Number of blocks in a chunk
+	static const std::size_t ChunkBlocks = 4096;
+
+	//! Size of a block including its header
+	std::size_t blockSize;
+	//! Allocated chunks
+	std::vector<std::unique_ptr<char[]>> chunks;
+	//! Blocks used in the last chunk
+	std::size_t chunkUsed = ChunkBlocks;
+	//! Released blocks, linked through their first bytes
+	void * freeList = nullptr;
+	//! Allocations not yet released
+	std::size_t live = 0;
+	//! The owner is done with the pool
+	bool orphaned = false;
+
+	QMutex lock;
+};
+
+#endif
@@ -355,36 +355,36 @@ void NifValue::clear()
 {
 	switch ( typ ) {
 	case tVector4:
-		delete static_cast<Vector4 *>( val.data );
+		destroy<Vector4>();
 		break;
 	case tVector3:
 	case tHalfVector3:
 	case tByteVector3:
-		delete static_cast<Vector3 *>( val.data );
+		destroy<Vector3>();
 		break;
 	case tVector2:
 	case tHalfVector2:
-		delete static_cast<Vector2 *>( val.data );
+		destroy<Vector2>();
 		break;
 	case tMatrix:
-		delete static_cast<Matrix *>( val.data );
+		destroy<Matrix>();
 		break;
 	case tMatrix4:
-		delete static_cast<Matrix4 *>( val.data );
+		destroy<Matrix4>();
 		break;
 	case tQuat:
 	case tQuatXYZW:
-		delete static_cast<Quat *>( val.data );
+		destroy<Quat>();
 		break;
 	case tByteMatrix:
-		delete static_cast<ByteMatrix *>( val.data );
+		destroy<ByteMatrix>();
 		break;
 	case tByteArray:
 	case tStringPalette:
-		delete static_cast<QByteArray *>( val.data );
+		destroy<QByteArray>();
 		break;
 	case tTriangle:
-		delete static_cast<Triangle *>( val.data );
+		destroy<Triangle>();
 		break;
 	case tString:
 	case tSizedString:
@@ -393,20 +393,21 @@ void NifValue::clear()
 	case tHeaderString:
 	case tLineString:
 	case tChar8String:
-		delete static_cast<QString *>( val.data );
+	case tFilePath:
+		destroy<QString>();
 		break;
 	case tColor3:
-		delete static_cast<Color3 *>( val.data );
+		destroy<Color3>();
 		break;
 	case tColor4:
 	case tByteColor4:
-		delete static_cast<Color4 *>( val.data );
+		destroy<Color4>();
 		break;
 	case tBSVertexDesc:
-		delete static_cast<BSVertexDesc *>(val.data);
+		destroy<BSVertexDesc>();
 		break;
 	case tBlob:
-		delete static_cast<QByteArray *>( val.data );
+		destroy<QByteArray>();
 		break;
 	default:
 		break;
@@ -432,27 +433,27 @@ void NifValue::changeType( Type t )
 	case tVector3:
 	case tHalfVector3:
 	case tByteVector3:
-		val.data = new Vector3();
+		create<Vector3>();
 		break;
 	case tVector4:
-		val.data = new Vector4();
+		create<Vector4>();
 		return;
 	case tMatrix:
-		val.data = new Matrix();
+		create<Matrix>();
 		return;
 	case tMatrix4:
-		val.data = new Matrix4();
+		create<Matrix4>();
 		return;
 	case tQuat:
 	case tQuatXYZW:
-		val.data = new Quat();
+		create<Quat>();
 		return;
 	case tVector2:
 	case tHalfVector2:
-		val.data = new Vector2();
+		create<Vector2>();
 		return;
 	case tTriangle:
-		val.data = new Triangle();
+		create<Triangle>();
 		return;
 	case tString:
 	case tSizedString:
@@ -461,31 +462,32 @@ void NifValue::changeType( Type t )
 	case tHeaderString:
 	case tLineString:
 	case tChar8String:
-		val.data = new QString();
+	case tFilePath:
+		create<QString>();
 		return;
 	case tColor3:
-		val.data = new Color3();
+		create<Color3>();
 		return;
 	case tColor4:
 	case tByteColor4:
-		val.data = new Color4();
+		create<Color4>();
 		return;
 	case tByteArray:
 	case tStringPalette:
-		val.data = new QByteArray();
+		create<QByteArray>();
 		return;
 	case tByteMatrix:
-		val.data = new ByteMatrix();
+		create<ByteMatrix>();
 		return;
 	case tStringOffset:
 	case tStringIndex:
 		val.u32 = 0xffffffff;
 		return;
 	case tBSVertexDesc:
-		val.data = new BSVertexDesc();
+		create<BSVertexDesc>();
 		return;
 	case tBlob:
-		val.data = new QByteArray();
+		create<QByteArray>();
 		return;
 	default:
 		val.u32 = 0;
@@ -493,6 +495,151 @@ void NifValue::changeType( Type t )
 	}
 }
 
+int NifValue::packedSize( Type t )
+{
+	switch ( t ) {
+	case tStringOffset:
+	case tStringIndex:
+		// Remapped by the string table on save
+		return 0;
+	case tFloat:
+	case tHfloat:
+		return sizeof( float );
+	case tVector3:
+	case tHalfVector3:
+	case tByteVector3:
+		return sizeof( Vector3 );
+	case tVector4:
+		return sizeof( Vector4 );
+	case tQuat:
+	case tQuatXYZW:
+		return sizeof( Quat );
+	case tVector2:
+	case tHalfVector2:
+		return sizeof( Vector2 );
+	case tTriangle:
+		return sizeof( Triangle );
+	case tColor3:
+		return sizeof( Color3 );
+	case tColor4:
+	case tByteColor4:
+		return sizeof( Color4 );
+	default:
+		if ( t >= tBool && t <= tUInt )
+			return sizeof( quint32 );
+		return 0;
+	}
+}
+
+int NifValue::heapSize() const
+{
+	switch ( typ ) {
+	case tMatrix:
+		return isInline<Matrix>() ? 0 : sizeof( Matrix );
+	case tMatrix4:
+		return isInline<Matrix4>() ? 0 : sizeof( Matrix4 );
+	case tByteMatrix:
+		return isInline<ByteMatrix>() ? 0 : sizeof( ByteMatrix );
+	default:
+		return 0;
+	}
+}
+
+void NifValue::toPacked( void * dst ) const
+{
+	int size = packedSize( typ );
+
+	if ( size == 0 )
+		return;
+
+	static_assert( isInline<Vector4>() && isInline<Quat>() && isInline<Color4>(), "packable payloads must be inline" );
+
+	// Packable payloads are all stored inline, at the start of the value like the scalars
+	memcpy( dst, &val, size );
+}
+
+void NifValue::fromPacked( const void * src )
+{
+	int size = packedSize( typ );
+
+	if ( size == 0 )
+		return;
+
+	memcpy( &val, src, size );
+}
+
+QDataStream & operator<<( QDataStream & ds, const NifValue & v )
+{
+	ds << quint8( v.typ );
+
+	if ( v.isCount() || v.isFloat() || v.isLink() || v.isFileVersion() ) {
+		ds << v.val.u32;
+	} else if ( v.isString() ) {
+		ds << v.get<QString>();
+	} else if ( int size = NifValue::packedSize( v.typ ) ) {
+		QByteArray data( size, 0 );
+		v.toPacked( data.data() );
+		ds << data;
+	}
+
+	return ds;
+}
+
+QDataStream & operator>>( QDataStream & ds, NifValue & v )
+{
+	quint8 t;
+	ds >> t;
+	v.changeType( NifValue::Type( t ) );
+
+	if ( v.isCount() || v.isFloat() || v.isLink() || v.isFileVersion() ) {
+		ds >> v.val.u32;
+	} else if ( v.isString() ) {
+		QString str;
+		ds >> str;
+		v.set<QString>( str );
+	} else if ( int size = NifValue::packedSize( v.typ ) ) {
+		QByteArray data;
+		ds >> data;
+		if ( data.size() == size )
+			v.fromPacked( data.constData() );
+	}
+
+	return ds;
+}
+
+void NifValue::writeTypeTables( QDataStream & ds )
+{
+	QHash<QString, quint8> types;
+	for ( auto it = typeMap.cbegin(); it != typeMap.cend(); ++it )
+		types.insert( it.key(), quint8( it.value() ) );
+
+	ds << types << typeTxt << aliasMap << quint32( enumMap.count() );
+
+	for ( auto it = enumMap.cbegin(); it != enumMap.cend(); ++it )
+		ds << it.key() << quint8( it.value().t ) << it.value().o;
+}
+
+void NifValue::readTypeTables( QDataStream & ds )
+{
+	QHash<QString, quint8> types;
+	quint32 enums;
+	ds >> types >> typeTxt >> aliasMap >> enums;
+
+	typeMap.clear();
+	for ( auto it = types.cbegin(); it != types.cend(); ++it )
+		typeMap.insert( it.key(), Type( it.value() ) );
+
+	enumMap.clear();
+	for ( quint32 i = 0; i < enums && ds.status() == QDataStream::Ok; i++ ) {
+		QString eid;
+		quint8 t;
+		EnumOptions options;
+		ds >> eid >> t >> options.o;
+		options.t = EnumType( t );
+		enumMap.insert( eid, options );
+	}
+}
+
 void NifValue::operator=( const NifValue & other )
 {
 	if ( typ != other.typ )
@@ -502,24 +649,24 @@ void NifValue::operator=( const NifValue & other )
 	case tVector3:
 	case tHalfVector3:
 	case tByteVector3:
-		*static_cast<Vector3 *>( val.data ) = *static_cast<Vector3 *>( other.val.data );
+		*ptr<Vector3>() = *other.ptr<Vector3>();
 		return;
 	case tVector4:
-		*static_cast<Vector4 *>( val.data ) = *static_cast<Vector4 *>( other.val.data );
+		*ptr<Vector4>() = *other.ptr<Vector4>();
 		return;
 	case tMatrix:
-		*static_cast<Matrix *>( val.data ) = *static_cast<Matrix *>( other.val.data );
+		*ptr<Matrix>() = *other.ptr<Matrix>();
 		return;
 	case tMatrix4:
-		*static_cast<Matrix4 *>( val.data ) = *static_cast<Matrix4 *>( other.val.data );
+		*ptr<Matrix4>() = *other.ptr<Matrix4>();
 		return;
 	case tQuat:
 	case tQuatXYZW:
-		*static_cast<Quat *>( val.data ) = *static_cast<Quat *>( other.val.data );
+		*ptr<Quat>() = *other.ptr<Quat>();
 		return;
 	case tVector2:
 	case tHalfVector2:
-		*static_cast<Vector2 *>( val.data ) = *static_cast<Vector2 *>( other.val.data );
+		*ptr<Vector2>() = *other.ptr<Vector2>();
 		return;
 	case tString:
 	case tSizedString:
@@ -528,30 +675,31 @@ void NifValue::operator=( const NifValue & other )
 	case tHeaderString:
 	case tLineString:
 	case tChar8String:
-		*static_cast<QString *>( val.data ) = *static_cast<QString *>( other.val.data );
+	case tFilePath:
+		*ptr<QString>() = *other.ptr<QString>();
 		return;
 	case tColor3:
-		*static_cast<Color3 *>( val.data ) = *static_cast<Color3 *>( other.val.data );
+		*ptr<Color3>() = *other.ptr<Color3>();
 		return;
 	case tColor4:
 	case tByteColor4:
-		*static_cast<Color4 *>( val.data ) = *static_cast<Color4 *>( other.val.data );
+		*ptr<Color4>() = *other.ptr<Color4>();
 		return;
 	case tByteArray:
 	case tStringPalette:
-		*static_cast<QByteArray *>( val.data ) = *static_cast<QByteArray *>( other.val.data );
+		*ptr<QByteArray>() = *other.ptr<QByteArray>();
 		return;
 	case tByteMatrix:
-		*static_cast<ByteMatrix *>( val.data ) = *static_cast<ByteMatrix *>( other.val.data );
+		*ptr<ByteMatrix>() = *other.ptr<ByteMatrix>();
 		return;
 	case tTriangle:
-		*static_cast<Triangle *>( val.data ) = *static_cast<Triangle *>( other.val.data );
+		*ptr<Triangle>() = *other.ptr<Triangle>();
 		return;
 	case tBlob:
-		*static_cast<QByteArray *>( val.data ) = *static_cast<QByteArray *>( other.val.data );
+		*ptr<QByteArray>() = *other.ptr<QByteArray>();
 		return;
 	case tBSVertexDesc:
-		*static_cast<BSVertexDesc *>(val.data) = *static_cast<BSVertexDesc *>(other.val.data);
+		*ptr<BSVertexDesc>() = *other.ptr<BSVertexDesc>();
 		return;
 	default:
 		val = other.val;
@@ -595,20 +743,16 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tLineString:
 	case tChar8String:
 	case tFilePath:
-	{
-		QString * s1 = static_cast<QString *>(val.data);
-		QString * s2 = static_cast<QString *>(other.val.data);
-
-		if ( !s1 || !s2 )
+		// Strings are kept inline, so only the type of the other value can be checked
+		if ( !other.isString() && other.typ != tFilePath )
 			return false;
 
-		return *s1 == *s2;
-	}
+		return *ptr<QString>() == *other.ptr<QString>();
 
 	case tColor3:
 	{
-		Color3 * c1 = static_cast<Color3 *>(val.data);
-		Color3 * c2 = static_cast<Color3 *>(other.val.data);
+		Color3 * c1 = ptr<Color3>();
+		Color3 * c2 = other.ptr<Color3>();
 
 		if ( !c1 || !c2 )
 			return false;
@@ -619,8 +763,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tColor4:
 	case tByteColor4:
 	{
-		Color4 * c1 = static_cast<Color4 *>(val.data);
-		Color4 * c2 = static_cast<Color4 *>(other.val.data);
+		Color4 * c1 = ptr<Color4>();
+		Color4 * c2 = other.ptr<Color4>();
 
 		if ( !c1 || !c2 )
 			return false;
@@ -631,8 +775,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tVector2:
 	case tHalfVector2:
 	{
-		Vector2 * vec1 = static_cast<Vector2 *>(val.data);
-		Vector2 * vec2 = static_cast<Vector2 *>(other.val.data);
+		Vector2 * vec1 = ptr<Vector2>();
+		Vector2 * vec2 = other.ptr<Vector2>();
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -644,8 +788,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tHalfVector3:
 	case tByteVector3:
 	{
-		Vector3 * vec1 = static_cast<Vector3 *>(val.data);
-		Vector3 * vec2 = static_cast<Vector3 *>(other.val.data);
+		Vector3 * vec1 = ptr<Vector3>();
+		Vector3 * vec2 = other.ptr<Vector3>();
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -655,8 +799,8 @@ bool NifValue::operator==( const NifValue & other ) const
 
 	case tVector4:
 	{
-		Vector4 * vec1 = static_cast<Vector4 *>(val.data);
-		Vector4 * vec2 = static_cast<Vector4 *>(other.val.data);
+		Vector4 * vec1 = ptr<Vector4>();
+		Vector4 * vec2 = other.ptr<Vector4>();
 
 		if ( !vec1 || !vec2 )
 			return false;
@@ -667,8 +811,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tQuat:
 	case tQuatXYZW:
 	{
-		Quat * quat1 = static_cast<Quat *>(val.data);
-		Quat * quat2 = static_cast<Quat *>(other.val.data);
+		Quat * quat1 = ptr<Quat>();
+		Quat * quat2 = other.ptr<Quat>();
 
 		if ( !quat1 || !quat2 )
 			return false;
@@ -678,8 +822,8 @@ bool NifValue::operator==( const NifValue & other ) const
 
 	case tTriangle:
 	{
-		Triangle * tri1 = static_cast<Triangle *>(val.data);
-		Triangle * tri2 = static_cast<Triangle *>(other.val.data);
+		Triangle * tri1 = ptr<Triangle>();
+		Triangle * tri2 = other.ptr<Triangle>();
 
 		if ( !tri1 || !tri2 )
 			return false;
@@ -692,8 +836,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	case tStringPalette:
 	case tBlob:
 	{
-		QByteArray * a1 = static_cast<QByteArray *>(val.data);
-		QByteArray * a2 = static_cast<QByteArray *>(other.val.data);
+		QByteArray * a1 = ptr<QByteArray>();
+		QByteArray * a2 = other.ptr<QByteArray>();
 
 		if ( a1->isNull() || a2->isNull() )
 			return false;
@@ -703,8 +847,8 @@ bool NifValue::operator==( const NifValue & other ) const
 
 	case tMatrix:
 	{
-		Matrix * m1 = static_cast<Matrix *>(val.data);
-		Matrix * m2 = static_cast<Matrix *>(other.val.data);
+		Matrix * m1 = ptr<Matrix>();
+		Matrix * m2 = other.ptr<Matrix>();
 
 		if ( !m1 || !m2 )
 			return false;
@@ -713,8 +857,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	}
 	case tMatrix4:
 	{
-		Matrix4 * m1 = static_cast<Matrix4 *>(val.data);
-		Matrix4 * m2 = static_cast<Matrix4 *>(other.val.data);
+		Matrix4 * m1 = ptr<Matrix4>();
+		Matrix4 * m2 = other.ptr<Matrix4>();
 
 		if ( !m1 || !m2 )
 			return false;
@@ -723,8 +867,8 @@ bool NifValue::operator==( const NifValue & other ) const
 	}
 	case tBSVertexDesc:
 	{
-		auto d1 = static_cast<BSVertexDesc *>(val.data);
-		auto d2 = static_cast<BSVertexDesc *>(other.val.data);
+		auto d1 = ptr<BSVertexDesc>();
+		auto d2 = other.ptr<BSVertexDesc>();
 
 		if ( !d1 || !d2 )
 			return false;
@@ -822,30 +966,30 @@ bool NifValue::setFromString( const QString & s )
 	case tHeaderString:
 	case tLineString:
 	case tChar8String:
-		*static_cast<QString *>( val.data ) = s;
+		*ptr<QString>() = s;
 		return true;
 	case tColor3:
-		static_cast<Color3 *>( val.data )->fromQColor( QColor( s ) );
+		ptr<Color3>()->fromQColor( QColor( s ) );
 		return true;
 	case tColor4:
 	case tByteColor4:
-		static_cast<Color4 *>( val.data )->fromQColor( QColor( s ) );
+		ptr<Color4>()->fromQColor( QColor( s ) );
 		return true;
 	case tFileVersion:
 		val.u32 = NifModel::version2number( s );
 		return val.u32 != 0;
 	case tVector2:
-		static_cast<Vector2 *>( val.data )->fromString( s );
+		ptr<Vector2>()->fromString( s );
 		return true;
 	case tVector3:
-		static_cast<Vector3 *>( val.data )->fromString( s );
+		ptr<Vector3>()->fromString( s );
 		return true;
 	case tVector4:
-		static_cast<Vector4 *>( val.data )->fromString( s );
+		ptr<Vector4>()->fromString( s );
 		return true;
 	case tQuat:
 	case tQuatXYZW:
-		static_cast<Quat *>( val.data )->fromString( s );
+		ptr<Quat>()->fromString( s );
 		return true;
 	case tByteArray:
 	case tByteMatrix:
@@ -896,10 +1040,10 @@ QString NifValue::toString() const
 	case tHeaderString:
 	case tLineString:
 	case tChar8String:
-		return *static_cast<QString *>( val.data );
+		return *ptr<QString>();
 	case tColor3:
 		{
-			Color3 * col = static_cast<Color3 *>( val.data );
+			Color3 * col = ptr<Color3>();
 			float r = col->red(), g = col->green(), b = col->blue();
 
 			// HDR Colors
@@ -914,7 +1058,7 @@ QString NifValue::toString() const
 	case tColor4:
 	case tByteColor4:
 		{
-			Color4 * col = static_cast<Color4 *>( val.data );
+			Color4 * col = ptr<Color4>();
 			float r = col->red(), g = col->green(), b = col->blue(), a = col->alpha();
 
 			// HDR Colors
@@ -933,7 +1077,7 @@ QString NifValue::toString() const
 	case tVector2:
 	case tHalfVector2:
 		{
-			Vector2 * v = static_cast<Vector2 *>( val.data );
+			Vector2 * v = ptr<Vector2>();
 
 			return QString( "X %1 Y %2" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -943,7 +1087,7 @@ QString NifValue::toString() const
 	case tHalfVector3:
 	case tByteVector3:
 		{
-			Vector3 * v = static_cast<Vector3 *>( val.data );
+			Vector3 * v = ptr<Vector3>();
 
 			return QString( "X %1 Y %2 Z %3" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -952,7 +1096,7 @@ QString NifValue::toString() const
 		}
 	case tVector4:
 		{
-			Vector4 * v = static_cast<Vector4 *>( val.data );
+			Vector4 * v = ptr<Vector4>();
 
 			return QString( "X %1 Y %2 Z %3 W %4" )
 			       .arg( NumOrMinMax( (*v)[0], 'f', VECTOR_DECIMALS ) )
@@ -967,9 +1111,9 @@ QString NifValue::toString() const
 			Matrix m;
 
 			if ( typ == tMatrix )
-				m = *( static_cast<Matrix *>( val.data ) );
+				m = *( ptr<Matrix>() );
 			else
-				m.fromQuat( *( static_cast<Quat *>( val.data ) ) );
+				m.fromQuat( *( ptr<Quat>() ) );
 
 			float x, y, z;
 			QString pre, suf;
@@ -986,7 +1130,7 @@ QString NifValue::toString() const
 		}
 	case tMatrix4:
 		{
-			Matrix4 * m = static_cast<Matrix4 *>( val.data );
+			Matrix4 * m = ptr<Matrix4>();
 			Matrix r; Vector3 t, s;
 			m->decompose( t, r, s );
 			float xr, yr, zr;
@@ -1007,10 +1151,10 @@ QString NifValue::toString() const
 		}
 	case tByteArray:
 		return QString( "%1 bytes" )
-		       .arg( static_cast<QByteArray *>( val.data )->count() );
+		       .arg( ptr<QByteArray>()->count() );
 	case tStringPalette:
 		{
-			QByteArray * array = static_cast<QByteArray *>( val.data );
+			QByteArray * array = ptr<QByteArray>();
 			QString s;
 
 			while ( s.length() < array->count() ) {
@@ -1022,7 +1166,7 @@ QString NifValue::toString() const
 		}
 	case tByteMatrix:
 		{
-			ByteMatrix * array = static_cast<ByteMatrix *>( val.data );
+			ByteMatrix * array = ptr<ByteMatrix>();
 			return QString( "%1 bytes  [%2 x %3]" )
 			       .arg( array->count() )
 			       .arg( array->count( 0 ) )
@@ -1032,7 +1176,7 @@ QString NifValue::toString() const
 		return NifModel::version2string( val.u32 );
 	case tTriangle:
 		{
-			Triangle * tri = static_cast<Triangle *>( val.data );
+			Triangle * tri = ptr<Triangle>();
 			return QString( "%1 %2 %3" )
 			       .arg( tri->v1() )
 			       .arg( tri->v2() )
@@ -1040,13 +1184,13 @@ QString NifValue::toString() const
 		}
 	case tFilePath:
 		{
-			return *static_cast<QString *>( val.data );
+			return *ptr<QString>();
 		}
 	case tBSVertexDesc:
-		return static_cast<BSVertexDesc *>(val.data)->toString();
+		return ptr<BSVertexDesc>()->toString();
 	case tBlob:
 		{
-			QByteArray * array = static_cast<QByteArray *>( val.data );
+			QByteArray * array = ptr<QByteArray>();
 			return QString( "%1 bytes" )
 				   .arg( array->size() );
 		}
@@ -1058,9 +1202,9 @@ QString NifValue::toString() const
 QColor NifValue::toColor() const
 {
 	if ( type() == tColor3 )
-		return static_cast<Color3 *>( val.data )->toQColor();
+		return ptr<Color3>()->toQColor();
 	else if ( type() == tColor4 || type() == tByteColor4 )
-		return static_cast<Color4 *>( val.data )->toQColor();
+		return ptr<Color4>()->toQColor();
 
 	return QColor();
 }
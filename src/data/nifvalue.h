@@ -41,6 +41,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QString>
 #include <QVariant>
 
+#include <new>
+
 
 //! @file nifvalue.h NifValue
 
@@ -71,6 +73,9 @@ class NifValue
 	friend class NifOStream;
 	friend class NifSStream;
 
+	friend QDataStream & operator<<( QDataStream & ds, const NifValue & v );
+	friend QDataStream & operator>>( QDataStream & ds, NifValue & v );
+
 public:
 	/*! List of all types implemented internally by NifSkope.
 	 *
@@ -231,6 +236,11 @@ public:
 	static QStringList enumOptions( const QString & eid );
 	//! Get type of enum for given enum type
 	static EnumType enumType( const QString & eid );
+
+	//! Write the type, alias, enum and description tables, e.g. to the schema cache
+	static void writeTypeTables( QDataStream & ds );
+	//! Replace the type, alias, enum and description tables with ones written by writeTypeTables()
+	static void readTypeTables( QDataStream & ds );
 	//! Get list of all options that have been registered for the given enum type.
 	static const EnumOptions & enumOptionData( const QString & eid );
 
@@ -333,6 +343,21 @@ public:
 	 */
 	bool setFromVariant( const QVariant & );
 
+	/*! Size of a value of the type in packed form.
+	 *
+	 * Only types of fixed size which hold no references or strings can be packed.
+	 * @return The size in bytes, or 0 if the type cannot be packed.
+	 */
+	static int packedSize( Type t );
+
+	//! Copy the value into a buffer of at least packedSize() bytes.
+	void toPacked( void * dst ) const;
+	//! Set the value from a buffer filled by toPacked(). The type is not changed.
+	void fromPacked( const void * src );
+
+	//! Get the size of the payload when it is kept on the heap; 0 if it is kept inline
+	int heapSize() const;
+
 	//! Check whether the data is of type T.
 	template <typename T> bool ask( T * t = 0 ) const;
 	//! Get the data in the form of something of type T.
@@ -353,11 +378,43 @@ protected:
 		qint32 i32;
 		float f32;
 		void * data;
+		//! Storage of payloads small enough to be kept inline, see ptr()
+		quint64 bytes[2];
 	};
 
 	//! The data value.
 	Value val = {0};
 
+	//! Is a payload of type T kept inline in the value rather than on the heap
+	template <typename T> static constexpr bool isInline()
+	{
+		return sizeof( T ) <= sizeof( Value ) && alignof( T ) <= alignof( Value );
+	}
+
+	//! Get the payload of the data as type T; the programmer must make sure that T matches the type of the data
+	template <typename T> T * ptr() const
+	{
+		return isInline<T>() ? reinterpret_cast<T *>( const_cast<Value *>( &val ) ) : static_cast<T *>( val.data );
+	}
+
+	//! Construct a payload of type T
+	template <typename T> void create()
+	{
+		if ( isInline<T>() )
+			new ( &val ) T();
+		else
+			val.data = new T();
+	}
+
+	//! Destroy the payload of type T
+	template <typename T> void destroy()
+	{
+		if ( isInline<T>() )
+			ptr<T>()->~T();
+		else
+			delete ptr<T>();
+	}
+
 	/*! Get the data as an object of type T.
 	 *
 	 * If the type t is not equal to the actual type of the data, then return T(). Serves
@@ -397,6 +454,11 @@ protected:
 
 Q_DECLARE_METATYPE( NifValue )
 
+//! Writes the type and value; values which are not counts, strings or packable are left out
+QDataStream & operator<<( QDataStream & ds, const NifValue & v );
+//! Reads a value written by operator<<()
+QDataStream & operator>>( QDataStream & ds, NifValue & v );
+
 
 
 // Inlines
@@ -478,7 +540,7 @@ inline bool NifValue::setFileVersion( quint32 v )
 template <typename T> inline T NifValue::getType( Type t ) const
 {
 	if ( typ == t )
-		return *static_cast<T *>( val.data ); // WARNING: this throws an exception if the type of v is not the original type by which val.data was initialized; the programmer must make sure that T matches t.
+		return *ptr<T>(); // WARNING: this throws an exception if the type of v is not the original type by which the data was initialized; the programmer must make sure that T matches t.
 
 	return T();
 }
@@ -486,7 +548,7 @@ template <typename T> inline T NifValue::getType( Type t ) const
 template <typename T> inline bool NifValue::setType( Type t, T v )
 {
 	if ( typ == t ) {
-		*static_cast<T *>( val.data ) = v; // WARNING: this throws an exception if the type of v is not the original type by which val.data was initialized; the programmer must make sure that T matches t.
+		*ptr<T>() = v; // WARNING: this throws an exception if the type of v is not the original type by which the data was initialized; the programmer must make sure that T matches t.
 		return true;
 	}
 
@@ -545,7 +607,7 @@ template <> inline Vector4 NifValue::get() const
 template <> inline Vector3 NifValue::get() const
 {
 	if ( typ == tVector3 || typ == tHalfVector3 )
-		return *static_cast<Vector3 *>(val.data);
+		return *ptr<Vector3>();
 
 	return Vector3();
 }
@@ -564,7 +626,7 @@ template <> inline HalfVector2 NifValue::get() const
 template <> inline Vector2 NifValue::get() const
 {
 	if ( typ == tVector2 || typ == tHalfVector2 )
-		return *static_cast<Vector2 *>(val.data);
+		return *ptr<Vector2>();
 
 	return Vector2();
 }
@@ -587,35 +649,35 @@ template <> inline Triangle NifValue::get() const
 template <> inline QString NifValue::get() const
 {
 	if ( isString() )
-		return *static_cast<QString *>( val.data );
+		return *ptr<QString>();
 
 	return QString();
 }
 template <> inline QByteArray NifValue::get() const
 {
 	if ( isByteArray() )
-		return *static_cast<QByteArray *>( val.data );
+		return *ptr<QByteArray>();
 
 	return QByteArray();
 }
 template <> inline QByteArray * NifValue::get() const
 {
 	if ( isByteArray() )
-		return static_cast<QByteArray *>( val.data );
+		return ptr<QByteArray>();
 
 	return nullptr;
 }
 template <> inline Quat NifValue::get() const
 {
 	if ( isQuat() )
-		return *static_cast<Quat *>( val.data );
+		return *ptr<Quat>();
 
 	return Quat();
 }
 template <> inline ByteMatrix * NifValue::get() const
 {
 	if ( isByteMatrix() )
-		return static_cast<ByteMatrix *>( val.data );
+		return ptr<ByteMatrix>();
 
 	return nullptr;
 }
@@ -723,11 +785,7 @@ template <> inline bool NifValue::set( const Triangle & x )
 template <> inline bool NifValue::set( const QString & x )
 {
 	if ( isString() ) {
-		if ( !val.data ) {
-			val.data = new QString;
-		}
-
-		*static_cast<QString *>( val.data ) = x;
+		*ptr<QString>() = x;
 		return true;
 	}
 
@@ -737,7 +795,7 @@ template <> inline bool NifValue::set( const QString & x )
 template <> inline bool NifValue::set( const QByteArray & x )
 {
 	if ( isByteArray() ) {
-		*static_cast<QByteArray *>( val.data ) = x;
+		*ptr<QByteArray>() = x;
 		return true;
 	}
 
@@ -747,7 +805,7 @@ template <> inline bool NifValue::set( const QByteArray & x )
 template <> inline bool NifValue::set( const Quat & x )
 {
 	if ( isQuat() ) {
-		*static_cast<Quat *>( val.data ) = x;
+		*ptr<Quat>() = x;
 		return true;
 	}
 
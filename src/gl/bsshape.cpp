@@ -7,6 +7,37 @@
 #include "model/nifmodel.h"
 
 
+//! Fields read whenever a shape is updated or transformed, interned once
+static const NifFieldId fieldVertexDesc( "Vertex Desc" );
+static const NifFieldId fieldSkin( "Skin" );
+static const NifFieldId fieldData( "Data" );
+static const NifFieldId fieldSkinPartition( "Skin Partition" );
+static const NifFieldId fieldVertexData( "Vertex Data" );
+static const NifFieldId fieldTriangles( "Triangles" );
+static const NifFieldId fieldNumVertices( "Num Vertices" );
+static const NifFieldId fieldNumTriangles( "Num Triangles" );
+static const NifFieldId fieldDataSize( "Data Size" );
+static const NifFieldId fieldVertexSize( "Vertex Size" );
+static const NifFieldId fieldBoundingSphere( "Bounding Sphere" );
+static const NifFieldId fieldCenter( "Center" );
+static const NifFieldId fieldRadius( "Radius" );
+static const NifFieldId fieldVertex( "Vertex" );
+static const NifFieldId fieldUV( "UV" );
+static const NifFieldId fieldBitangentX( "Bitangent X" );
+static const NifFieldId fieldBitangentY( "Bitangent Y" );
+static const NifFieldId fieldBitangentZ( "Bitangent Z" );
+static const NifFieldId fieldNormal( "Normal" );
+static const NifFieldId fieldTangent( "Tangent" );
+static const NifFieldId fieldVertexColors( "Vertex Colors" );
+static const NifFieldId fieldVertices( "Vertices" );
+static const NifFieldId fieldPartition( "Partition" );
+static const NifFieldId fieldSkeletonRoot( "Skeleton Root" );
+static const NifFieldId fieldBones( "Bones" );
+static const NifFieldId fieldBoneWeights( "Bone Weights" );
+static const NifFieldId fieldBoneIndices( "Bone Indices" );
+static const NifFieldId fieldBoneList( "Bone List" );
+
+
 BSShape::BSShape( Scene * s, const QModelIndex & b ) : Shape( s, b )
 {
 	
@@ -56,7 +87,7 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 	if ( isLOD )
 		emit nif->lodSliderChanged( true );
 
-	auto vertexFlags = nif->get<BSVertexDesc>( iBlock, "Vertex Desc" );
+	auto vertexFlags = nif->get<BSVertexDesc>( iBlock, fieldVertexDesc );
 
 	hasVertexColors = vertexFlags.HasFlag( VertexAttribute::VA_COLOR );
 
@@ -72,13 +103,13 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 		skinDataName = "NiSkinData";
 	}
 
-	iSkin = nif->getBlock( nif->getLink( nif->getIndex( iBlock, "Skin" ) ), skinInstName );
+	iSkin = nif->getBlock( nif->getLink( nif->getIndex( iBlock, fieldSkin ) ), skinInstName );
 	if ( !iSkin.isValid() )
 		isSkinned = false;
 
 	if ( isSkinned ) {
-		iSkinData = nif->getBlock( nif->getLink( iSkin, "Data" ), skinDataName );
-		iSkinPart = nif->getBlock( nif->getLink( iSkin, "Skin Partition" ), "NiSkinPartition" );
+		iSkinData = nif->getBlock( nif->getLink( iSkin, fieldData ), skinDataName );
+		iSkinPart = nif->getBlock( nif->getLink( iSkin, fieldSkinPartition ), "NiSkinPartition" );
 
 		if ( nifVersion == 100 )
 			isDataOnSkin = true;
@@ -91,30 +122,30 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 
 	int dataSize = 0;
 	if ( !isDataOnSkin ) {
-		iVertData = nif->getIndex( iBlock, "Vertex Data" );
-		iTriData = nif->getIndex( iBlock, "Triangles" );
+		iVertData = nif->getIndex( iBlock, fieldVertexData );
+		iTriData = nif->getIndex( iBlock, fieldTriangles );
 		iData = iVertData;
 		if ( !iVertData.isValid() || !iTriData.isValid() )
 			return;
 
-		numVerts = std::min( nif->get<int>( iBlock, "Num Vertices" ), nif->rowCount( iVertData ) );
-		numTris = std::min( nif->get<int>( iBlock, "Num Triangles" ), nif->rowCount( iTriData ) );
+		numVerts = std::min( nif->get<int>( iBlock, fieldNumVertices ), nif->rowCount( iVertData ) );
+		numTris = std::min( nif->get<int>( iBlock, fieldNumTriangles ), nif->rowCount( iTriData ) );
 
-		dataSize = nif->get<int>( iBlock, "Data Size" );
+		dataSize = nif->get<int>( iBlock, fieldDataSize );
 	} else {
 		// For skinned geometry, the vertex data is stored on the NiSkinPartition
 		// The triangles are split up among the partitions
 
-		iSkinPart = nif->getBlock( nif->getLink( iSkin, "Skin Partition" ), "NiSkinPartition" );
+		iSkinPart = nif->getBlock( nif->getLink( iSkin, fieldSkinPartition ), "NiSkinPartition" );
 		if ( !iSkinPart.isValid() )
 			return;
 
-		iVertData = nif->getIndex( iSkinPart, "Vertex Data" );
+		iVertData = nif->getIndex( iSkinPart, fieldVertexData );
 		iTriData = QModelIndex();
 		iData = iVertData;
 
-		dataSize = nif->get<int>( iSkinPart, "Data Size" );
-		auto vertexSize = nif->get<int>( iSkinPart, "Vertex Size" );
+		dataSize = nif->get<int>( iSkinPart, fieldDataSize );
+		auto vertexSize = nif->get<int>( iSkinPart, fieldVertexSize );
 		if ( !iVertData.isValid() || dataSize == 0 || vertexSize == 0 )
 			return;
 
@@ -122,10 +153,10 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 	}
 
 
-	auto bsphere = nif->getIndex( iBlock, "Bounding Sphere" );
+	auto bsphere = nif->getIndex( iBlock, fieldBoundingSphere );
 	if ( bsphere.isValid() ) {
-		bsphereCenter = nif->get<Vector3>( bsphere, "Center" );
-		bsphereRadius = nif->get<float>( bsphere, "Radius" );
+		bsphereCenter = nif->get<Vector3>( bsphere, fieldCenter );
+		bsphereRadius = nif->get<float>( bsphere, fieldRadius );
 	}
 
 	if ( iBlock == index && dataSize > 0 ) {
@@ -144,30 +175,30 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 			auto idx = nif->index( i, 0, iVertData );
 
 			if ( !isDynamic )
-				verts << nif->get<Vector3>( idx, "Vertex" );
+				verts << nif->get<Vector3>( idx, fieldVertex );
 
-			coordset << nif->get<HalfVector2>( idx, "UV" );
+			coordset << nif->get<HalfVector2>( idx, fieldUV );
 
 			// Bitangent X
-			auto bitX = nif->getValue( nif->getIndex( idx, "Bitangent X" ) ).toFloat();
+			auto bitX = nif->getValue( nif->getIndex( idx, fieldBitangentX ) ).toFloat();
 			// Bitangent Y/Z
-			auto bitYi = nif->getValue( nif->getIndex( idx, "Bitangent Y" ) ).toCount();
-			auto bitZi = nif->getValue( nif->getIndex( idx, "Bitangent Z" ) ).toCount();
+			auto bitYi = nif->getValue( nif->getIndex( idx, fieldBitangentY ) ).toCount();
+			auto bitZi = nif->getValue( nif->getIndex( idx, fieldBitangentZ ) ).toCount();
 			auto bitY = (double( bitYi ) / 255.0) * 2.0 - 1.0;
 			auto bitZ = (double( bitZi ) / 255.0) * 2.0 - 1.0;
 
-			norms += nif->get<ByteVector3>( idx, "Normal" );
-			tangents += nif->get<ByteVector3>( idx, "Tangent" );
+			norms += nif->get<ByteVector3>( idx, fieldNormal );
+			tangents += nif->get<ByteVector3>( idx, fieldTangent );
 			bitangents += Vector3( bitX, bitY, bitZ );
 
-			auto vcIdx = nif->getIndex( idx, "Vertex Colors" );
+			auto vcIdx = nif->getIndex( idx, fieldVertexColors );
 			if ( vcIdx.isValid() ) {
 				colors += nif->get<ByteColor4>( vcIdx );
 			}
 		}
 
 		if ( isDynamic ) {
-			auto dynVerts = nif->getArray<Vector4>( iBlock, "Vertices" );
+			auto dynVerts = nif->getArray<Vector4>( iBlock, fieldVertices );
 			for ( const auto & v : dynVerts )
 				verts << Vector3( v );
 		}
@@ -179,9 +210,9 @@ void BSShape::update( const NifModel * nif, const QModelIndex & index )
 			triangles = nif->getArray<Triangle>( iTriData );
 			triangles = triangles.mid( 0, numTris );
 		} else {
-			auto partIdx = nif->getIndex( iSkinPart, "Partition" );
+			auto partIdx = nif->getIndex( iSkinPart, fieldPartition );
 			for ( int i = 0; i < nif->rowCount( partIdx ); i++ )
-				triangles << nif->getArray<Triangle>( nif->index( i, 0, partIdx ), "Triangles" );
+				triangles << nif->getArray<Triangle>( nif->index( i, 0, partIdx ), fieldTriangles );
 		}
 	}
 
@@ -204,12 +235,12 @@ QModelIndex BSShape::vertexAt( int idx ) const
 	auto blk = iBlock;
 	if ( nifVersion < 130 && iSkinPart.isValid() ) {
 		if ( nif->inherits( blk, "BSDynamicTriShape" ) )
-			return nif->getIndex( blk, "Vertices" ).child( idx, 0 );
+			return nif->getIndex( blk, fieldVertices ).child( idx, 0 );
 
 		blk = iSkinPart;
 	}
 
-	return nif->getIndex( nif->getIndex( blk, "Vertex Data" ).child( idx, 0 ), "Vertex" );
+	return nif->getIndex( nif->getIndex( blk, fieldVertexData ).child( idx, 0 ), fieldVertex );
 }
 
 
@@ -237,19 +268,19 @@ void BSShape::transform()
 		partitions.clear();
 
 		if ( iSkin.isValid() && iSkinData.isValid() ) {
-			skeletonRoot = nif->getLink( iSkin, "Skeleton Root" );
+			skeletonRoot = nif->getLink( iSkin, fieldSkeletonRoot );
 			if ( nifVersion < 130 )
 				skeletonTrans = Transform( nif, iSkinData );
 
-			bones = nif->getLinkArray( iSkin, "Bones" );
+			bones = nif->getLinkArray( iSkin, fieldBones );
 			weights.fill( BoneWeights(), bones.count() );
 			for ( int i = 0; i < bones.count(); i++ )
 				weights[i].bone = bones[i];
 
 			for ( int i = 0; i < numVerts; i++ ) {
 				auto idx = nif->index( i, 0, iVertData );
-				auto wts = nif->getArray<float>( idx, "Bone Weights" );
-				auto bns = nif->getArray<quint8>( idx, "Bone Indices" );
+				auto wts = nif->getArray<float>( idx, fieldBoneWeights );
+				auto bns = nif->getArray<quint8>( idx, fieldBoneIndices );
 				if ( wts.count() < 4 || bns.count() < 4 )
 					continue;
 
@@ -262,7 +293,7 @@ void BSShape::transform()
 				}
 			}
 
-			auto b = nif->getIndex( iSkinData, "Bone List" );
+			auto b = nif->getIndex( iSkinData, fieldBoneList );
 			for ( int i = 0; i < weights.count(); i++ )
 				weights[i].setTransform( nif, b.child( i, 0 ) );
 
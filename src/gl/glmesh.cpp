@@ -48,6 +48,41 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //! @file glmesh.cpp Scene management for visible meshes such as NiTriShapes.
 
+//! Fields read whenever a mesh is transformed, interned once
+static const NifFieldId fieldStream( "Stream" );
+static const NifFieldId fieldUsage( "Usage" );
+static const NifFieldId fieldAccess( "Access" );
+static const NifFieldId fieldComponentSemantics( "Component Semantics" );
+static const NifFieldId fieldNumComponents( "Num Components" );
+static const NifFieldId fieldName( "Name" );
+static const NifFieldId fieldIndex( "Index" );
+static const NifFieldId fieldNumSubmeshes( "Num Submeshes" );
+static const NifFieldId fieldSubmeshToRegionMap( "Submesh To Region Map" );
+static const NifFieldId fieldNumRegions( "Num Regions" );
+static const NifFieldId fieldRegions( "Regions" );
+static const NifFieldId fieldStartIndex( "Start Index" );
+static const NifFieldId fieldNumIndices( "Num Indices" );
+static const NifFieldId fieldComponentFormats( "Component Formats" );
+static const NifFieldId fieldData( "Data" );
+static const NifFieldId fieldPrimitiveType( "Primitive Type" );
+static const NifFieldId fieldVertices( "Vertices" );
+static const NifFieldId fieldNormals( "Normals" );
+static const NifFieldId fieldVertexColors( "Vertex Colors" );
+static const NifFieldId fieldTangents( "Tangents" );
+static const NifFieldId fieldBitangents( "Bitangents" );
+static const NifFieldId fieldUVSets( "UV Sets" );
+static const NifFieldId fieldUVSets2( "UV Sets 2" );
+static const NifFieldId fieldTriangles( "Triangles" );
+static const NifFieldId fieldPoints( "Points" );
+static const NifFieldId fieldExtraDataList( "Extra Data List" );
+static const NifFieldId fieldBinaryData( "Binary Data" );
+static const NifFieldId fieldSkinPartition( "Skin Partition" );
+static const NifFieldId fieldSkeletonRoot( "Skeleton Root" );
+static const NifFieldId fieldBones( "Bones" );
+static const NifFieldId fieldBoneList( "Bone List" );
+static const NifFieldId fieldHasVertexWeights( "Has Vertex Weights" );
+static const NifFieldId fieldSkinPartitionBlocks( "Skin Partition Blocks" );
+
 const char * NIMESH_ABORT = QT_TR_NOOP( "NiMesh rendering encountered unsupported types. Rendering may be broken." );
 
 
@@ -336,24 +371,24 @@ void Mesh::transform()
 			using CompSemIdxMap = QVector<QPair<NiMesh::Semantic, uint>>;
 			QVector<CompSemIdxMap> compSemanticIndexMaps;
 			for ( int i = 0; i < nif->rowCount( iData ); i++ ) {
-				auto stream = nif->getLink( iData.child( i, 0 ), "Stream" );
+				auto stream = nif->getLink( iData.child( i, 0 ), fieldStream );
 				auto iDataStream = nif->getBlock( stream );
 
-				auto usage = NiMesh::DataStreamUsage( nif->get<uint>( iDataStream, "Usage" ) );
-				auto access = nif->get<uint>( iDataStream, "Access" );
+				auto usage = NiMesh::DataStreamUsage( nif->get<uint>( iDataStream, fieldUsage ) );
+				auto access = nif->get<uint>( iDataStream, fieldAccess );
 
 				// Invalid Usage and Access, abort
 				if ( usage == access && access == 0 )
 					return;
 
 				// For each datastream, store the semantic and the index (used for E_TEXCOORD)
-				auto iComponentSemantics = nif->getIndex( iData.child( i, 0 ), "Component Semantics" );
-				uint numComponents = nif->get<uint>( iData.child( i, 0 ), "Num Components" );
+				auto iComponentSemantics = nif->getIndex( iData.child( i, 0 ), fieldComponentSemantics );
+				uint numComponents = nif->get<uint>( iData.child( i, 0 ), fieldNumComponents );
 				CompSemIdxMap compSemanticIndexMap;
 				for ( uint j = 0; j < numComponents; j++ ) {
-					auto name = nif->get<QString>( iComponentSemantics.child( j, 0 ), "Name" );
+					auto name = nif->get<QString>( iComponentSemantics.child( j, 0 ), fieldName );
 					auto sem = NiMesh::semanticStrings.value( name );
-					uint idx = nif->get<uint>( iComponentSemantics.child( j, 0 ), "Index" );
+					uint idx = nif->get<uint>( iComponentSemantics.child( j, 0 ), fieldIndex );
 					compSemanticIndexMap.insert( j, {sem, idx} );
 
 					// Create UV stubs for multi-coord systems
@@ -395,16 +430,16 @@ void Mesh::transform()
 				// filled in order for each data stream.
 				// Submeshes may be required if total index values exceed USHRT_MAX
 				QMap<ushort, ushort> submeshMap;
-				ushort numSubmeshes = nif->get<ushort>( iData.child( i, 0 ), "Num Submeshes" );
-				auto iSubmeshMap = nif->getIndex( iData.child( i, 0 ), "Submesh To Region Map" );
+				ushort numSubmeshes = nif->get<ushort>( iData.child( i, 0 ), fieldNumSubmeshes );
+				auto iSubmeshMap = nif->getIndex( iData.child( i, 0 ), fieldSubmeshToRegionMap );
 				for ( ushort j = 0; j < numSubmeshes; j++ )
 					submeshMap.insert( j, nif->get<ushort>( iSubmeshMap.child( j, 0 ) ) );
 
 				// Get the datastream
-				quint32 stream = nif->getLink( iData.child( i, 0 ), "Stream" );
+				quint32 stream = nif->getLink( iData.child( i, 0 ), fieldStream );
 				auto iDataStream = nif->getBlock( stream );
 
-				auto usage = NiMesh::DataStreamUsage(nif->get<uint>( iDataStream, "Usage" ));
+				auto usage = NiMesh::DataStreamUsage(nif->get<uint>( iDataStream, fieldUsage ));
 				// Only process USAGE_VERTEX and USAGE_VERTEX_INDEX
 				if ( usage > NiMesh::USAGE_VERTEX )
 					continue;
@@ -412,13 +447,13 @@ void Mesh::transform()
 				// Datastream can be split into multiple regions
 				// Each region has a Start Index which is added as an offset to the index read from the stream
 				QVector<QPair<quint32, quint32>> regions;
-				quint32 numRegions = nif->get<quint32>( iDataStream, "Num Regions" );
+				quint32 numRegions = nif->get<quint32>( iDataStream, fieldNumRegions );
 				quint32 numIndices = 0;
-				auto iRegions = nif->getIndex( iDataStream, "Regions" );
+				auto iRegions = nif->getIndex( iDataStream, fieldRegions );
 				if ( iRegions.isValid() ) {
 					for ( quint32 j = 0; j < numRegions; j++ ) {
-						regions.append( { nif->get<quint32>( iRegions.child( j, 0 ), "Start Index" ),
-										nif->get<quint32>( iRegions.child( j, 0 ), "Num Indices" ) }
+						regions.append( { nif->get<quint32>( iRegions.child( j, 0 ), fieldStartIndex ),
+										nif->get<quint32>( iRegions.child( j, 0 ), fieldNumIndices ) }
 						);
 
 						numIndices += regions[j].second;
@@ -451,9 +486,9 @@ void Mesh::transform()
 
 				// Get the format of each component
 				QVector<NiMesh::DataStreamFormat> datastreamFormats;
-				uint numStreamComponents = nif->get<uint>( iDataStream, "Num Components" );
+				uint numStreamComponents = nif->get<uint>( iDataStream, fieldNumComponents );
 				for ( uint j = 0; j < numStreamComponents; j++ ) {
-					auto format = nif->get<uint>( nif->getIndex( iDataStream, "Component Formats" ).child( j, 0 ) );
+					auto format = nif->get<uint>( nif->getIndex( iDataStream, fieldComponentFormats ).child( j, 0 ) );
 					datastreamFormats.append( NiMesh::DataStreamFormat(format) );
 				}
 
@@ -461,7 +496,7 @@ void Mesh::transform()
 
 				auto tempMdl = std::make_unique<NifModel>( this );
 
-				QByteArray streamData = nif->get<QByteArray>( nif->getIndex( iDataStream, "Data" ).child( 0, 0 ) );
+				QByteArray streamData = nif->get<QByteArray>( nif->getIndex( iDataStream, fieldData ).child( 0, 0 ) );
 				QBuffer streamBuffer( &streamData );
 				streamBuffer.open( QIODevice::ReadOnly );
 
@@ -633,7 +668,7 @@ void Mesh::transform()
 
 			// Make geometry
 			triangles.resize( indices.size() / 3 );
-			auto meshPrimitiveType = nif->get<uint>( iBlock, "Primitive Type" );
+			auto meshPrimitiveType = nif->get<uint>( iBlock, fieldPrimitiveType );
 			switch ( meshPrimitiveType ) {
 			case NiMesh::PRIMITIVE_TRIANGLES:
 				for ( int k = 0, t = 0; k < indices.size(); k += 3, t++ )
@@ -653,9 +688,9 @@ void Mesh::transform()
 			}
 		} else {
 
-			verts  = nif->getArray<Vector3>( iData, "Vertices" );
-			norms  = nif->getArray<Vector3>( iData, "Normals" );
-			colors = nif->getArray<Color4>( iData, "Vertex Colors" );
+			verts  = nif->getArray<Vector3>( iData, fieldVertices );
+			norms  = nif->getArray<Vector3>( iData, fieldNormals );
+			colors = nif->getArray<Color4>( iData, fieldVertexColors );
 
 			// Detect if "Has Vertex Colors" is set to Yes in NiTriShape
 			//	Used to compare against SLSF2_Vertex_Colors
@@ -669,8 +704,8 @@ void Mesh::transform()
 					colors[i].setRGBA( colors[i].red(), colors[i].green(), colors[i].blue(), 1 );
 			}
 
-			tangents   = nif->getArray<Vector3>( iData, "Tangents" );
-			bitangents = nif->getArray<Vector3>( iData, "Bitangents" );
+			tangents   = nif->getArray<Vector3>( iData, fieldTangents );
+			bitangents = nif->getArray<Vector3>( iData, fieldBitangents );
 
 			if ( norms.count() < verts.count() )
 				norms.clear();
@@ -679,10 +714,10 @@ void Mesh::transform()
 				colors.clear();
 
 			coords.clear();
-			QModelIndex uvcoord = nif->getIndex( iData, "UV Sets" );
+			QModelIndex uvcoord = nif->getIndex( iData, fieldUVSets );
 
 			if ( !uvcoord.isValid() )
-				uvcoord = nif->getIndex( iData, "UV Sets 2" );
+				uvcoord = nif->getIndex( iData, fieldUVSets2 );
 
 			if ( uvcoord.isValid() ) {
 				for ( int r = 0; r < nif->rowCount( uvcoord ); r++ ) {
@@ -698,7 +733,7 @@ void Mesh::transform()
 			if ( nif->itemName( iData ) == "NiTriShapeData" ) {
 				// check indexes
 				// TODO: check other indexes as well
-				QVector<Triangle> ftriangles = nif->getArray<Triangle>( iData, "Triangles" );
+				QVector<Triangle> ftriangles = nif->getArray<Triangle>( iData, fieldTriangles );
 				triangles.clear();
 				int inv_idx = 0;
 				int inv_cnt = 0;
@@ -722,7 +757,7 @@ void Mesh::transform()
 				ftriangles.clear();
 
 				if ( inv_cnt > 0 ) {
-					int block_idx = nif->getBlockNumber( nif->getIndex( iData, "Triangles" ) );
+					int block_idx = nif->getBlockNumber( nif->getIndex( iData, fieldTriangles ) );
 					Message::append( tr( "Warnings were generated while rendering mesh." ),
 						tr( "Block %1: %2 invalid indices in NiTriShapeData.Triangles" ).arg( block_idx ).arg( inv_cnt )
 					);
@@ -731,7 +766,7 @@ void Mesh::transform()
 				tristrips.clear();
 			} else if ( nif->itemName( iData ) == "NiTriStripsData" ) {
 				tristrips.clear();
-				QModelIndex points = nif->getIndex( iData, "Points" );
+				QModelIndex points = nif->getIndex( iData, fieldPoints );
 
 				if ( points.isValid() ) {
 					for ( int r = 0; r < nif->rowCount( points ); r++ )
@@ -750,15 +785,15 @@ void Mesh::transform()
 				tristrips.clear();
 			}
 
-			QModelIndex iExtraData = nif->getIndex( iBlock, "Extra Data List" );
+			QModelIndex iExtraData = nif->getIndex( iBlock, fieldExtraDataList );
 
 			if ( iExtraData.isValid() ) {
 				for ( int e = 0; e < nif->rowCount( iExtraData ); e++ ) {
 					QModelIndex iExtra = nif->getBlock( nif->getLink( iExtraData.child( e, 0 ) ), "NiBinaryExtraData" );
 
-					if ( nif->get<QString>( iExtra, "Name" ) == "Tangent space (binormal & tangent vectors)" ) {
+					if ( nif->get<QString>( iExtra, fieldName ) == "Tangent space (binormal & tangent vectors)" ) {
 						iTangentData = iExtra;
-						QByteArray data = nif->get<QByteArray>( iExtra, "Binary Data" );
+						QByteArray data = nif->get<QByteArray>( iExtra, fieldBinaryData );
 
 						if ( data.count() == verts.count() * 4 * 3 * 2 ) {
 							tangents.resize( verts.count() );
@@ -783,20 +818,20 @@ void Mesh::transform()
 		weights.clear();
 		partitions.clear();
 
-		iSkinData = nif->getBlock( nif->getLink( iSkin, "Data" ), "NiSkinData" );
-		iSkinPart = nif->getBlock( nif->getLink( iSkin, "Skin Partition" ), "NiSkinPartition" );
+		iSkinData = nif->getBlock( nif->getLink( iSkin, fieldData ), "NiSkinData" );
+		iSkinPart = nif->getBlock( nif->getLink( iSkin, fieldSkinPartition ), "NiSkinPartition" );
 		if ( !iSkinPart.isValid() )
 			// nif versions < 10.2.0.0 have skin partition linked in the skin data block
-			iSkinPart = nif->getBlock( nif->getLink( iSkinData, "Skin Partition" ), "NiSkinPartition" );
+			iSkinPart = nif->getBlock( nif->getLink( iSkinData, fieldSkinPartition ), "NiSkinPartition" );
 
-		skeletonRoot  = nif->getLink( iSkin, "Skeleton Root" );
+		skeletonRoot  = nif->getLink( iSkin, fieldSkeletonRoot );
 		skeletonTrans = Transform( nif, iSkinData );
 
-		bones = nif->getLinkArray( iSkin, "Bones" );
+		bones = nif->getLinkArray( iSkin, fieldBones );
 
-		QModelIndex idxBones = nif->getIndex( iSkinData, "Bone List" );
+		QModelIndex idxBones = nif->getIndex( iSkinData, fieldBoneList );
 		if ( idxBones.isValid() ) {
-			bool hvw = nif->get<unsigned char>( iSkinData, "Has Vertex Weights" );
+			bool hvw = nif->get<unsigned char>( iSkinData, fieldHasVertexWeights );
 			// Ignore weights listed in NiSkinData if NiSkinPartition exists
 			hvw = hvw && !iSkinPart.isValid();
 			int vcnt = hvw ? verts.count() : 0;
@@ -806,7 +841,7 @@ void Mesh::transform()
 		}
 
 		if ( iSkinPart.isValid() && doSkinning ) {
-			QModelIndex idx = nif->getIndex( iSkinPart, "Skin Partition Blocks" );
+			QModelIndex idx = nif->getIndex( iSkinPart, fieldSkinPartitionBlocks );
 
 			uint numTris = 0;
 			uint numStrips = 0;
@@ -44,6 +44,16 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 //! @file glproperty.cpp Encapsulation of NiProperty blocks defined in nif.xml
 
+//! Fields read each time a texture is bound, interned once
+static const NifFieldId fieldFileName( "File Name" );
+static const NifFieldId fieldNumTextures( "Num Textures" );
+static const NifFieldId fieldTextures( "Textures" );
+static const NifFieldId fieldSourceTexture( "Source Texture" );
+static const NifFieldId fieldGreyscaleTexture( "Greyscale Texture" );
+static const NifFieldId fieldEnvMapTexture( "Env Map Texture" );
+static const NifFieldId fieldNormalTexture( "Normal Texture" );
+static const NifFieldId fieldEnvMaskTexture( "Env Mask Texture" );
+
 //! Helper function that checks texture sets
 bool checkSet( int s, const QVector<QVector<Vector2> > & texcoords )
 {
@@ -488,7 +498,7 @@ QString TexturingProperty::fileName( int id ) const
 		const NifModel * nif = qobject_cast<const NifModel *>( iSource.model() );
 
 		if ( nif && iSource.isValid() ) {
-			return nif->get<QString>( iSource, "File Name" );
+			return nif->get<QString>( iSource, fieldFileName );
 		}
 	}
 
@@ -592,7 +602,7 @@ QString TextureProperty::fileName() const
 	const NifModel * nif = qobject_cast<const NifModel *>( iImage.model() );
 
 	if ( nif && iImage.isValid() )
-		return nif->get<QString>( iImage, "File Name" );
+		return nif->get<QString>( iImage, fieldFileName );
 
 	return QString();
 }
@@ -1007,8 +1017,8 @@ QString BSShaderLightingProperty::fileName( int id ) const
 
 	nif = qobject_cast<const NifModel *>(iTextureSet.model());
 	if ( nif && iTextureSet.isValid() ) {
-		int nTextures = nif->get<int>( iTextureSet, "Num Textures" );
-		QModelIndex iTextures = nif->getIndex( iTextureSet, "Textures" );
+		int nTextures = nif->get<int>( iTextureSet, fieldNumTextures );
+		QModelIndex iTextures = nif->getIndex( iTextureSet, fieldTextures );
 
 		if ( id >= 0 && id < nTextures )
 			return nif->get<QString>( iTextures.child( id, 0 ) );
@@ -1020,15 +1030,15 @@ QString BSShaderLightingProperty::fileName( int id ) const
 		if ( !m && nif && iSourceTexture.isValid() ) {
 			switch ( id ) {
 			case 0:
-				return nif->get<QString>( iSourceTexture, "Source Texture" );
+				return nif->get<QString>( iSourceTexture, fieldSourceTexture );
 			case 1:
-				return nif->get<QString>( iSourceTexture, "Greyscale Texture" );
+				return nif->get<QString>( iSourceTexture, fieldGreyscaleTexture );
 			case 2:
-				return nif->get<QString>( iSourceTexture, "Env Map Texture" );
+				return nif->get<QString>( iSourceTexture, fieldEnvMapTexture );
 			case 3:
-				return nif->get<QString>( iSourceTexture, "Normal Texture" );
+				return nif->get<QString>( iSourceTexture, fieldNormalTexture );
 			case 4:
-				return nif->get<QString>( iSourceTexture, "Env Mask Texture" );
+				return nif->get<QString>( iSourceTexture, fieldEnvMaskTexture );
 			}
 		} else if ( m && m->isValid() ) {
 			auto tex = m->textures();
@@ -233,20 +233,11 @@ QString TexCache::find( const QString & file, const QString & nifdir, QByteArray
 		}
 
 		// Search through archives last, and load any requested textures into memory.
-		for ( FSArchiveFile * archive : FSManager::archiveList() ) {
-			if ( archive ) {
-				filename = QDir::fromNativeSeparators( filename.toLower() );
-				if ( archive->hasFile( filename ) ) {
-					QByteArray outData;
-					archive->fileContents( filename, outData );
-
-					if ( !outData.isEmpty() ) {
-						data = outData;
-						filename = QDir::toNativeSeparators( filename );
-						return filename;
-					}
-				}
-			}
+		QByteArray outData;
+		if ( FSManager::fileContents( filename, outData ) && !outData.isEmpty() ) {
+			data = outData;
+			filename = QDir::toNativeSeparators( FSManager::normalizePath( filename ) );
+			return filename;
 		}
 
 		// For Skyrim and FO4 which occasionally leave the textures off
@@ -116,19 +116,9 @@ QByteArray Material::find( QString path )
 		}
 	}
 
-	for ( FSArchiveFile * archive : FSManager::archiveList() ) {
-		if ( archive ) {
-			filename = QDir::fromNativeSeparators( path.toLower() );
-			if ( archive->hasFile( filename ) ) {
-				QByteArray outData;
-				archive->fileContents( filename, outData );
-
-				if ( !outData.isEmpty() ) {
-					return outData;
-				}
-			}
-		}
-	}
+	QByteArray outData;
+	if ( FSManager::fileContents( path, outData ) && !outData.isEmpty() )
+		return outData;
 
 	return QByteArray();
 }
@@ -37,8 +37,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "lib/half.h"
 
+#include <QBuffer>
 #include <QDataStream>
 #include <QIODevice>
+#include <QtEndian>
 
 
 //! @file nifstream.cpp NIF file I/O
@@ -47,6 +49,21 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *  NifIStream
 */
 
+//! Convert words read directly from the device from the byte order of the file
+template <typename T> static void fromFileOrder( void * data, int words, bool bigEndian )
+{
+	T * w = static_cast<T *>( data );
+
+	if ( bigEndian ) {
+		for ( int i = 0; i < words; i++ )
+			w[i] = qFromBigEndian( w[i] );
+	} else {
+		// No-op on little-endian hosts
+		for ( int i = 0; i < words; i++ )
+			w[i] = qFromLittleEndian( w[i] );
+	}
+}
+
 void NifIStream::init()
 {
 	bool32bit = (model->inherits( "NifModel" ) && model->getVersionNumber() <= 0x04000002);
@@ -59,6 +76,197 @@ void NifIStream::init()
 	dataStream->setFloatingPointPrecision( QDataStream::SinglePrecision );
 
 	maxLength = 0x8000;
+
+	mapped = model->mappedBuffer && device == model->mappedBuffer;
+}
+
+bool NifIStream::readMapped( QByteArray & array, int len )
+{
+	const QByteArray & data = static_cast<QBuffer *>( device )->data();
+	qint64 pos = device->pos();
+
+	if ( len < 0 || pos + len > data.size() )
+		return false;
+
+	array = QByteArray::fromRawData( data.constData() + pos, len );
+	return device->seek( pos + len );
+}
+
+bool NifIStream::readPacked( const NifValue & element, char * dst, int count )
+{
+	const int size = NifValue::packedSize( element.type() );
+
+	if ( size == 0 || count < 0 )
+		return false;
+
+	if ( count == 0 )
+		return true;
+
+	// Types whose packed form matches the file layout, as 32-bit or 16-bit words
+	int words32 = 0, words16 = 0;
+	// Byte order of the words; some types are always little-endian
+	bool swap = bigEndian;
+
+	switch ( element.type() ) {
+	case NifValue::tBool:
+		if ( bool32bit )
+			words32 = 1;
+		break;
+	case NifValue::tInt:
+	case NifValue::tUInt:
+	case NifValue::tFloat:
+		words32 = 1;
+		break;
+	case NifValue::tULittle32:
+		words32 = 1;
+		swap = false;
+		break;
+	case NifValue::tVector2:
+		words32 = 2;
+		break;
+	case NifValue::tVector3:
+		words32 = 3;
+		break;
+	case NifValue::tColor3:
+		// Read directly from the device by read()
+		words32 = 3;
+		swap = false;
+		break;
+	case NifValue::tVector4:
+	case NifValue::tColor4:
+	case NifValue::tQuat:
+		words32 = 4;
+		break;
+	case NifValue::tTriangle:
+		words16 = 3;
+		break;
+	default:
+		break;
+	}
+
+	if ( words32 || words16 ) {
+		const qint64 len = qint64( count ) * size;
+		if ( device->read( dst, len ) != len )
+			return false;
+
+		if ( words32 )
+			fromFileOrder<quint32>( dst, count * words32, swap );
+		else
+			fromFileOrder<quint16>( dst, count * words16, swap );
+
+		return true;
+	}
+
+	// Types which are widened or expanded from a narrower file layout
+	int width = 0;
+
+	switch ( element.type() ) {
+	case NifValue::tBool:
+	case NifValue::tByte:
+		width = 1;
+		break;
+	case NifValue::tWord:
+	case NifValue::tShort:
+	case NifValue::tFlags:
+	case NifValue::tBlockTypeIndex:
+	case NifValue::tHfloat:
+		width = 2;
+		break;
+	case NifValue::tByteVector3:
+		width = 3;
+		break;
+	case NifValue::tHalfVector2:
+	case NifValue::tByteColor4:
+		width = 4;
+		break;
+	case NifValue::tHalfVector3:
+		width = 6;
+		break;
+	case NifValue::tQuatXYZW:
+		width = 16;
+		break;
+	default:
+		break;
+	}
+
+	if ( width == 0 ) {
+		// No bulk layout, read value by value
+		NifValue v( element );
+		for ( int i = 0; i < count; i++ ) {
+			if ( !read( v ) )
+				return false;
+			v.toPacked( dst + i * size );
+		}
+		return true;
+	}
+
+	QByteArray buffer = device->read( qint64( count ) * width );
+	if ( buffer.size() != count * width )
+		return false;
+
+	const uchar * src = reinterpret_cast<const uchar *>( buffer.constData() );
+	quint32 * out = reinterpret_cast<quint32 *>( dst );
+
+	switch ( element.type() ) {
+	case NifValue::tBool:
+	case NifValue::tByte:
+		for ( int i = 0; i < count; i++ )
+			out[i] = src[i];
+		break;
+	case NifValue::tWord:
+	case NifValue::tShort:
+	case NifValue::tFlags:
+	case NifValue::tBlockTypeIndex:
+		{
+			quint16 * w = reinterpret_cast<quint16 *>( buffer.data() );
+			fromFileOrder<quint16>( w, count, bigEndian );
+			for ( int i = 0; i < count; i++ )
+				out[i] = w[i];
+		}
+		break;
+	case NifValue::tHfloat:
+	case NifValue::tHalfVector2:
+	case NifValue::tHalfVector3:
+		{
+			// Components are contiguous in both layouts
+			const int n = count * width / 2;
+			quint16 * h = reinterpret_cast<quint16 *>( buffer.data() );
+			fromFileOrder<quint16>( h, n, bigEndian );
+			for ( int i = 0; i < n; i++ )
+				out[i] = half_to_float( h[i] );
+		}
+		break;
+	case NifValue::tByteVector3:
+		{
+			float * f = reinterpret_cast<float *>( dst );
+			for ( int i = 0; i < count * 3; i++ )
+				f[i] = (double( src[i] ) / 255.0) * 2.0 - 1.0;
+		}
+		break;
+	case NifValue::tByteColor4:
+		{
+			float * f = reinterpret_cast<float *>( dst );
+			for ( int i = 0; i < count * 4; i++ )
+				f[i] = (float)src[i] / 255.0;
+		}
+		break;
+	case NifValue::tQuatXYZW:
+		{
+			// Read directly from the device by read(); stored as WXYZ
+			const quint32 * q = reinterpret_cast<const quint32 *>( src );
+			for ( int i = 0; i < count; i++, q += 4, out += 4 ) {
+				out[0] = q[3];
+				out[1] = q[0];
+				out[2] = q[1];
+				out[3] = q[2];
+			}
+		}
+		break;
+	default:
+		break;
+	}
+
+	return true;
 }
 
 bool NifIStream::read( NifValue & val )
@@ -149,7 +357,7 @@ bool NifIStream::read( NifValue & val )
 			yf = (double( y ) / 255.0) * 2.0 - 1.0;
 			zf = (double( z ) / 255.0) * 2.0 - 1.0;
 
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = val.ptr<Vector3>();
 			v->xyz[0] = xf; v->xyz[1] = yf; v->xyz[2] = zf;
 
 			return (dataStream->status() == QDataStream::Ok);
@@ -167,7 +375,7 @@ bool NifIStream::read( NifValue & val )
 			yu.i = half_to_float( y );
 			zu.i = half_to_float( z );
 
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = val.ptr<Vector3>();
 			v->xyz[0] = xu.f; v->xyz[1] = yu.f; v->xyz[2] = zu.f;
 
 			return (dataStream->status() == QDataStream::Ok);
@@ -183,52 +391,52 @@ bool NifIStream::read( NifValue & val )
 			xu.i = half_to_float( x );
 			yu.i = half_to_float( y );
 
-			Vector2 * v = static_cast<Vector2 *>(val.val.data);
+			Vector2 * v = val.ptr<Vector2>();
 			v->xy[0] = xu.f; v->xy[1] = yu.f;
 
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tVector3:
 		{
-			Vector3 * v = static_cast<Vector3 *>(val.val.data);
+			Vector3 * v = val.ptr<Vector3>();
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tVector4:
 		{
-			Vector4 * v = static_cast<Vector4 *>(val.val.data);
+			Vector4 * v = val.ptr<Vector4>();
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tTriangle:
 		{
-			Triangle * t = static_cast<Triangle *>(val.val.data);
+			Triangle * t = val.ptr<Triangle>();
 			*dataStream >> *t;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tQuat:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
+			Quat * q = val.ptr<Quat>();
 			*dataStream >> *q;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tQuatXYZW:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
+			Quat * q = val.ptr<Quat>();
 			return device->read( (char *)&q->wxyz[1], 12 ) == 12 && device->read( (char *)q->wxyz, 4 ) == 4;
 		}
 	case NifValue::tMatrix:
-		return device->read( (char *)static_cast<Matrix *>(val.val.data)->m, 36 ) == 36;
+		return device->read( (char *)val.ptr<Matrix>()->m, 36 ) == 36;
 	case NifValue::tMatrix4:
-		return device->read( (char *)static_cast<Matrix4 *>(val.val.data)->m, 64 ) == 64;
+		return device->read( (char *)val.ptr<Matrix4>()->m, 64 ) == 64;
 	case NifValue::tVector2:
 		{
-			Vector2 * v = static_cast<Vector2 *>(val.val.data);
+			Vector2 * v = val.ptr<Vector2>();
 			*dataStream >> *v;
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tColor3:
-		return device->read( (char *)static_cast<Color3 *>(val.val.data)->rgb, 12 ) == 12;
+		return device->read( (char *)val.ptr<Color3>()->rgb, 12 ) == 12;
 	case NifValue::tByteColor4:
 		{
 			quint8 r, g, b, a;
@@ -237,14 +445,14 @@ bool NifIStream::read( NifValue & val )
 			*dataStream >> b;
 			*dataStream >> a;
 
-			Color4 * c = static_cast<Color4 *>(val.val.data);
+			Color4 * c = val.ptr<Color4>();
 			c->setRGBA( (float)r / 255.0, (float)g / 255.0, (float)b / 255.0, (float)a / 255.0 );
 
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tColor4:
 		{
-			Color4 * c = static_cast<Color4 *>(val.val.data);
+			Color4 * c = val.ptr<Color4>();
 			*dataStream >> *c;
 			return (dataStream->status() == QDataStream::Ok);
 		}
@@ -255,7 +463,7 @@ bool NifIStream::read( NifValue & val )
 			*dataStream >> len;
 
 			if ( len > maxLength || len < 0 ) {
-				*static_cast<QString *>(val.val.data) = tr( "<string too long (0x%1)>" ).arg( len, 0, 16 ); return false;
+				*val.ptr<QString>() = tr( "<string too long (0x%1)>" ).arg( len, 0, 16 ); return false;
 			}
 
 			QByteArray string = device->read( len );
@@ -265,7 +473,7 @@ bool NifIStream::read( NifValue & val )
 
 			//string.replace( "\r", "\\r" );
 			//string.replace( "\n", "\\n" );
-			*static_cast<QString *>(val.val.data) = QString( string );
+			*val.ptr<QString>() = QString( string );
 		}
 		return true;
 	case NifValue::tShortString:
@@ -279,7 +487,7 @@ bool NifIStream::read( NifValue & val )
 
 			//string.replace( "\r", "\\r" );
 			//string.replace( "\n", "\\n" );
-			*static_cast<QString *>(val.val.data) = QString::fromLocal8Bit( string );
+			*val.ptr<QString>() = QString::fromLocal8Bit( string );
 		}
 		return true;
 	case NifValue::tText:
@@ -288,7 +496,7 @@ bool NifIStream::read( NifValue & val )
 			device->read( (char *)&len, 4 );
 
 			if ( len > maxLength || len < 0 ) {
-				*static_cast<QString *>(val.val.data) = tr( "<string too long>" ); return false;
+				*val.ptr<QString>() = tr( "<string too long>" ); return false;
 			}
 
 			QByteArray string = device->read( len );
@@ -296,7 +504,7 @@ bool NifIStream::read( NifValue & val )
 			if ( string.size() != len )
 				return false;
 
-			*static_cast<QString *>(val.val.data) = QString( string );
+			*val.ptr<QString>() = QString( string );
 		}
 		return true;
 	case NifValue::tByteArray:
@@ -307,8 +515,11 @@ bool NifIStream::read( NifValue & val )
 			if ( len < 0 )
 				return false;
 
-			*static_cast<QByteArray *>(val.val.data) = device->read( len );
-			return static_cast<QByteArray *>(val.val.data)->count() == len;
+			if ( mapped )
+				return readMapped( *val.ptr<QByteArray>(), len );
+
+			*val.ptr<QByteArray>() = device->read( len );
+			return val.ptr<QByteArray>()->count() == len;
 		}
 	case NifValue::tStringPalette:
 		{
@@ -318,7 +529,7 @@ bool NifIStream::read( NifValue & val )
 			if ( len > 0xffff || len < 0 )
 				return false;
 
-			*static_cast<QByteArray *>(val.val.data) = device->read( len );
+			*val.ptr<QByteArray>() = device->read( len );
 			device->read( (char *)&len, 4 );
 			return true;
 		}
@@ -334,7 +545,7 @@ bool NifIStream::read( NifValue & val )
 			int len = len1 * len2;
 			ByteMatrix tmp( len1, len2 );
 			qint64 rlen = device->read( tmp.data(), len );
-			tmp.swap( *static_cast<ByteMatrix *>(val.val.data) );
+			tmp.swap( *val.ptr<ByteMatrix>() );
 			return (rlen == len);
 		}
 	case NifValue::tHeaderString:
@@ -349,7 +560,7 @@ bool NifIStream::read( NifValue & val )
 			if ( c >= 80 )
 				return false;
 
-			*static_cast<QString *>(val.val.data) = QString( string );
+			*val.ptr<QString>() = QString( string );
 			bool x = model->setHeaderString( QString( string ) );
 			init();
 			return x;
@@ -366,7 +577,7 @@ bool NifIStream::read( NifValue & val )
 			if ( c >= 255 )
 				return false;
 
-			*static_cast<QString *>(val.val.data) = QString( string );
+			*val.ptr<QString>() = QString( string );
 			return true;
 		}
 	case NifValue::tChar8String:
@@ -381,7 +592,7 @@ bool NifIStream::read( NifValue & val )
 			if ( c > 9 )
 				return false;
 
-			*static_cast<QString *>(val.val.data) = QString( string );
+			*val.ptr<QString>() = QString( string );
 			return true;
 		}
 	case NifValue::tFileVersion:
@@ -420,7 +631,7 @@ bool NifIStream::read( NifValue & val )
 				device->read( (char *)&len, 4 );
 
 				if ( len > maxLength || len < 0 ) {
-					*static_cast<QString *>(val.val.data) = tr( "<string too long>" ); return false;
+					*val.ptr<QString>() = tr( "<string too long>" ); return false;
 				}
 
 				QByteArray string = device->read( len );
@@ -430,7 +641,7 @@ bool NifIStream::read( NifValue & val )
 
 				//string.replace( "\r", "\\r" );
 				//string.replace( "\n", "\\n" );
-				*static_cast<QString *>(val.val.data) = QString( string );
+				*val.ptr<QString>() = QString( string );
 				return true;
 			}
 		}
@@ -446,7 +657,7 @@ bool NifIStream::read( NifValue & val )
 				device->read( (char *)&len, 4 );
 
 				if ( len > maxLength || len < 0 ) {
-					*static_cast<QString *>(val.val.data) = tr( "<string too long>" ); return false;
+					*val.ptr<QString>() = tr( "<string too long>" ); return false;
 				}
 
 				QByteArray string = device->read( len );
@@ -454,23 +665,22 @@ bool NifIStream::read( NifValue & val )
 				if ( string.size() != len )
 					return false;
 
-				*static_cast<QString *>(val.val.data) = QString( string );
+				*val.ptr<QString>() = QString( string );
 				return true;
 			}
 		}
 	case NifValue::tBSVertexDesc:
 		{
-			*dataStream >> *static_cast<BSVertexDesc *>(val.val.data);
+			*dataStream >> *val.ptr<BSVertexDesc>();
 			return (dataStream->status() == QDataStream::Ok);
 		}
 	case NifValue::tBlob:
 		{
-			if ( val.val.data ) {
-				QByteArray * array = static_cast<QByteArray *>(val.val.data);
-				return device->read( array->data(), array->size() ) == array->size();
-			}
+			QByteArray * array = val.ptr<QByteArray>();
+			if ( mapped )
+				return readMapped( *array, array->size() );
 
-			return false;
+			return device->read( array->data(), array->size() ) == array->size();
 		}
 	case NifValue::tNone:
 		return true;
@@ -551,7 +761,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tByteVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = val.ptr<Vector3>();
 			if ( !vec )
 				return false;
 
@@ -564,7 +774,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tHalfVector3:
 		{
-			Vector3 * vec = static_cast<Vector3 *>(val.val.data);
+			Vector3 * vec = val.ptr<Vector3>();
 			if ( !vec )
 				return false;
 
@@ -583,7 +793,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tHalfVector2:
 		{
-			Vector2 * vec = static_cast<Vector2 *>(val.val.data);
+			Vector2 * vec = val.ptr<Vector2>();
 			if ( !vec )
 				return false;
 
@@ -599,29 +809,29 @@ bool NifOStream::write( const NifValue & val )
 			return device->write( (char*)v, 4 ) == 4;
 		}
 	case NifValue::tVector3:
-		return device->write( (char *)static_cast<Vector3 *>(val.val.data)->xyz, 12 ) == 12;
+		return device->write( (char *)val.ptr<Vector3>()->xyz, 12 ) == 12;
 	case NifValue::tVector4:
-		return device->write( (char *)static_cast<Vector4 *>(val.val.data)->xyzw, 16 ) == 16;
+		return device->write( (char *)val.ptr<Vector4>()->xyzw, 16 ) == 16;
 	case NifValue::tTriangle:
-		return device->write( (char *)static_cast<Triangle *>(val.val.data)->v, 6 ) == 6;
+		return device->write( (char *)val.ptr<Triangle>()->v, 6 ) == 6;
 	case NifValue::tQuat:
-		return device->write( (char *)static_cast<Quat *>(val.val.data)->wxyz, 16 ) == 16;
+		return device->write( (char *)val.ptr<Quat>()->wxyz, 16 ) == 16;
 	case NifValue::tQuatXYZW:
 		{
-			Quat * q = static_cast<Quat *>(val.val.data);
+			Quat * q = val.ptr<Quat>();
 			return device->write( (char *)&q->wxyz[1], 12 ) == 12 && device->write( (char *)q->wxyz, 4 ) == 4;
 		}
 	case NifValue::tMatrix:
-		return device->write( (char *)static_cast<Matrix *>(val.val.data)->m, 36 ) == 36;
+		return device->write( (char *)val.ptr<Matrix>()->m, 36 ) == 36;
 	case NifValue::tMatrix4:
-		return device->write( (char *)static_cast<Matrix4 *>(val.val.data)->m, 64 ) == 64;
+		return device->write( (char *)val.ptr<Matrix4>()->m, 64 ) == 64;
 	case NifValue::tVector2:
-		return device->write( (char *)static_cast<Vector2 *>(val.val.data)->xy, 8 ) == 8;
+		return device->write( (char *)val.ptr<Vector2>()->xy, 8 ) == 8;
 	case NifValue::tColor3:
-		return device->write( (char *)static_cast<Color3 *>(val.val.data)->rgb, 12 ) == 12;
+		return device->write( (char *)val.ptr<Color3>()->rgb, 12 ) == 12;
 	case NifValue::tByteColor4:
 		{
-			Color4 * color = static_cast<Color4 *>(val.val.data);
+			Color4 * color = val.ptr<Color4>();
 			if ( !color )
 				return false;
 
@@ -635,10 +845,10 @@ bool NifOStream::write( const NifValue & val )
 			return device->write( (char*)c, 4 ) == 4;
 		}
 	case NifValue::tColor4:
-		return device->write( (char *)static_cast<Color4 *>(val.val.data)->rgba, 16 ) == 16;
+		return device->write( (char *)val.ptr<Color4>()->rgba, 16 ) == 16;
 	case NifValue::tSizedString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			//string.replace( "\\r", "\r" );
 			//string.replace( "\\n", "\n" );
 			int len = string.size();
@@ -650,7 +860,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tShortString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLocal8Bit();
+			QByteArray string = val.ptr<QString>()->toLocal8Bit();
 			string.replace( "\\r", "\r" );
 			string.replace( "\\n", "\n" );
 
@@ -666,7 +876,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tText:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			int len = string.size();
 
 			if ( device->write( (char *)&len, 4 ) != 4 )
@@ -677,7 +887,7 @@ bool NifOStream::write( const NifValue & val )
 	case NifValue::tHeaderString:
 	case NifValue::tLineString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 
 			if ( device->write( string.constData(), string.length() ) != string.length() )
 				return false;
@@ -686,7 +896,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tChar8String:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			quint32 n = std::min<quint32>( 8, string.length() );
 
 			if ( device->write( string.constData(), n ) != n )
@@ -702,7 +912,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tByteArray:
 		{
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
+			QByteArray * array = val.ptr<QByteArray>();
 			int len = array->count();
 
 			if ( device->write( (char *)&len, 4 ) != 4 )
@@ -712,7 +922,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tStringPalette:
 		{
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
+			QByteArray * array = val.ptr<QByteArray>();
 			int len = array->count();
 
 			if ( device->write( (char *)&len, 4 ) != 4 )
@@ -725,7 +935,7 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tByteMatrix:
 		{
-			ByteMatrix * array = static_cast<ByteMatrix *>(val.val.data);
+			ByteMatrix * array = val.ptr<ByteMatrix>();
 			int len = array->count( 0 );
 
 			if ( device->write( (char *)&len, 4 ) != 4 )
@@ -750,11 +960,7 @@ bool NifOStream::write( const NifValue & val )
 					return device->write( (char *)&value, 4 ) == 4;
 				}
 			} else {
-				QByteArray string;
-
-				if ( val.val.data != 0 ) {
-					string = static_cast<QString *>(val.val.data)->toLatin1();
-				}
+				QByteArray string = val.ptr<QString>()->toLatin1();
 
 				//string.replace( "\\r", "\r" );
 				//string.replace( "\\n", "\n" );
@@ -768,20 +974,17 @@ bool NifOStream::write( const NifValue & val )
 		}
 	case NifValue::tBSVertexDesc:
 		{
-			auto d = static_cast<BSVertexDesc *>(val.val.data);
+			auto d = val.ptr<BSVertexDesc>();
 			if ( !d )
 				return false;
 
 			return device->write( (char*)&d->desc, 8 ) == 8;
 		}
 	case NifValue::tBlob:
-
-		if ( val.val.data ) {
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
+		{
+			QByteArray * array = val.ptr<QByteArray>();
 			return device->write( array->data(), array->size() ) == array->size();
 		}
-
-		return true;
 	case NifValue::tNone:
 		return true;
 	}
@@ -859,14 +1062,14 @@ int NifSStream::size( const NifValue & val )
 		return 16;
 	case NifValue::tSizedString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			//string.replace( "\\r", "\r" );
 			//string.replace( "\\n", "\n" );
 			return 4 + string.size();
 		}
 	case NifValue::tShortString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 
 			//string.replace( "\\r", "\r" );
 			//string.replace( "\\n", "\n" );
@@ -877,13 +1080,13 @@ int NifSStream::size( const NifValue & val )
 		}
 	case NifValue::tText:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			return 4 + string.size();
 		}
 	case NifValue::tHeaderString:
 	case NifValue::tLineString:
 		{
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			return string.length() + 1;
 		}
 	case NifValue::tChar8String:
@@ -892,17 +1095,17 @@ int NifSStream::size( const NifValue & val )
 		}
 	case NifValue::tByteArray:
 		{
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
+			QByteArray * array = val.ptr<QByteArray>();
 			return 4 + array->count();
 		}
 	case NifValue::tStringPalette:
 		{
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
+			QByteArray * array = val.ptr<QByteArray>();
 			return 4 + array->count() + 4;
 		}
 	case NifValue::tByteMatrix:
 		{
-			ByteMatrix * array = static_cast<ByteMatrix *>(val.val.data);
+			ByteMatrix * array = val.ptr<ByteMatrix>();
 			return 4 + 4 + array->count();
 		}
 	case NifValue::tString:
@@ -911,21 +1114,14 @@ int NifSStream::size( const NifValue & val )
 			if ( stringAdjust ) {
 				return 4;
 			}
-			QByteArray string = static_cast<QString *>(val.val.data)->toLatin1();
+			QByteArray string = val.ptr<QString>()->toLatin1();
 			//string.replace( "\\r", "\r" );
 			//string.replace( "\\n", "\n" );
 			return 4 + string.size();
 		}
 
 	case NifValue::tBlob:
-
-		if ( val.val.data ) {
-			QByteArray * array = static_cast<QByteArray *>(val.val.data);
-			return array->size();
-		}
-
-		return 0;
-
+		return val.ptr<QByteArray>()->size();
 	case NifValue::tNone:
 		return 0;
 	}
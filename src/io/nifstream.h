@@ -42,6 +42,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 class NifValue;
 class BaseModel;
+class QByteArray;
 class QDataStream;
 class QIODevice;
 
@@ -60,6 +61,17 @@ public:
 	//! Reads a NifValue from the underlying device. Returns true if successful.
 	bool read( NifValue & );
 
+	/*! Reads an array of values from the underlying device into packed storage.
+	 *
+	 * Fixed size types are read with one device read and decoded in place.
+	 *
+	 * @param element	A value of the element type
+	 * @param dst		A buffer of count * NifValue::packedSize() bytes, filled as by NifValue::toPacked()
+	 * @param count		The number of elements
+	 * @return			True if successful
+	 */
+	bool readPacked( const NifValue & element, char * dst, int count );
+
 private:
 	//! The model that data is being read into.
 	BaseModel * model;
@@ -71,6 +83,9 @@ private:
 	//! Initialises the stream.
 	void init();
 
+	//! Refers to the next len bytes of a memory mapped device instead of copying them.
+	bool readMapped( QByteArray & array, int len );
+
 	//! Whether a boolean is 32-bit.
 	bool bool32bit = false;
 	//! Whether link adjustment is required.
@@ -79,6 +94,8 @@ private:
 	bool stringAdjust = false;
 	//! Whether the model is big-endian
 	bool bigEndian = false;
+	//! Whether the device is a memory mapped file, see BaseModel::loadFromFile()
+	bool mapped = false;
 
 	//! The maximum length of a string that can be read.
 	int maxLength = 0x8000;
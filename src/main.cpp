@@ -31,6 +31,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***** END LICENCE BLOCK *****/
 
 #include "nifskope.h"
+#include "benchmark.h"
 #include "version.h"
 #include "data/nifvalue.h"
 #include "model/nifmodel.h"
@@ -148,7 +149,26 @@ int main( int argc, char * argv[] )
 			return 0;
 		}
 	} else {
-		// Future command line batch tools here
+		app->setOrganizationName( "NifTools" );
+		app->setOrganizationDomain( "niftools.org" );
+		app->setApplicationName( "NifSkope " + NifSkopeVersion::rawToMajMin( NIFSKOPE_VERSION ) );
+		app->setApplicationVersion( NIFSKOPE_VERSION );
+
+		// Command line tools
+		QCommandLineParser parser;
+		parser.setSingleDashWordOptionMode( QCommandLineParser::ParseAsLongOptions );
+		parser.addHelpOption();
+
+		QCommandLineOption noGuiOption( "no-gui", "Start without the user interface" );
+		parser.addOption( noGuiOption );
+
+		QCommandLineOption benchOption( "bench", "Run the benchmark <name> over the files and folders given, \"help\" lists them", "name" );
+		parser.addOption( benchOption );
+
+		parser.process( *app );
+
+		if ( parser.isSet( benchOption ) )
+			return Benchmark::run( parser.value( benchOption ), parser.positionalArguments() );
 	}
 
 	return 0;
@@ -39,6 +39,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QBuffer>
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
 #include <QTime>
 
 
@@ -50,7 +52,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 BaseModel::BaseModel( QObject * p ) : QAbstractItemModel( p )
 {
-	root = new NifItem( 0 );
+	if ( NifItemPool::isEnabled() )
+		itemPool = new NifItemPool( sizeof( NifItem ) );
+
+	root = new ( itemPool ) NifItem( 0 );
 	parentWindow = qobject_cast<QWidget *>(p);
 	msgMode = TstMessage;
 }
@@ -58,6 +63,10 @@ BaseModel::BaseModel( QObject * p ) : QAbstractItemModel( p )
 BaseModel::~BaseModel()
 {
 	delete root;
+
+	// Items moved to other models keep the pool alive
+	if ( itemPool )
+		itemPool->orphan();
 }
 
 QWidget * BaseModel::getWindow()
@@ -77,29 +86,55 @@ void BaseModel::setMessageMode( MsgMode mode )
 
 void BaseModel::testMsg( const QString & m ) const
 {
+	QMutexLocker lock( &messageLock );
 	messages.append( TestMessage() << m );
 }
 
 void BaseModel::beginInsertRows( const QModelIndex & parent, int first, int last )
 {
+	// No view knows the rows of a block being decoded concurrently
+	if ( concurrentLoad )
+		return;
+
+	itemChanged( parent.isValid() ? static_cast<NifItem *>( parent.internalPointer() ) : root );
+
 	setState( Inserting );
 	QAbstractItemModel::beginInsertRows( parent, first, last );
 }
 
 void BaseModel::endInsertRows()
 {
+	if ( concurrentLoad )
+		return;
+
 	QAbstractItemModel::endInsertRows();
 	restoreState();
 }
 
 void BaseModel::beginRemoveRows( const QModelIndex & parent, int first, int last )
 {
+	if ( concurrentLoad )
+		return;
+
+	NifItem * item = parent.isValid() ? static_cast<NifItem *>( parent.internalPointer() ) : root;
+
+	// Rows of the root are tracked on their own, so they are dropped one by one
+	if ( item == root ) {
+		for ( int r = first; r <= last && r < root->childCount(); r++ )
+			itemChanged( root->child( r ) );
+	}
+
+	itemChanged( item );
+
 	setState( Removing );
 	QAbstractItemModel::beginRemoveRows( parent, first, last );
 }
 
 void BaseModel::endRemoveRows()
 {
+	if ( concurrentLoad )
+		return;
+
 	QAbstractItemModel::endRemoveRows();
 	restoreState();
 }
@@ -115,6 +150,7 @@ bool BaseModel::getProcessingResult()
 
 QList<TestMessage> BaseModel::getMessages() const
 {
+	QMutexLocker lock( &messageLock );
 	QList<TestMessage> lst = messages;
 	messages.clear();
 	return lst;
@@ -355,6 +391,16 @@ int BaseModel::rowCount( const QModelIndex & parent ) const
 	return ( parentItem ? parentItem->childCount() : 0 );
 }
 
+bool BaseModel::hasChildren( const QModelIndex & parent ) const
+{
+	NifItem * item = static_cast<NifItem *>( parent.internalPointer() );
+
+	if ( parent.isValid() && parent.model() == this && item && item->isDeferred() )
+		return true;
+
+	return QAbstractItemModel::hasChildren( parent );
+}
+
 QVariant BaseModel::data( const QModelIndex & index, int role ) const
 {
 	NifItem * item = static_cast<NifItem *>( index.internalPointer() );
@@ -517,6 +563,7 @@ bool BaseModel::setData( const QModelIndex & index, const QVariant & value, int
 		item->setType( value.toString() );
 		break;
 	case BaseModel::ValueCol:
+		itemChanging( item );
 		item->value().setFromVariant( value );
 		break;
 	case BaseModel::ArgCol:
@@ -544,6 +591,8 @@ bool BaseModel::setData( const QModelIndex & index, const QVariant & value, int
 		return false;
 	}
 
+	itemChanged( item );
+
 	if ( state == Default )
 		emit dataChanged( index, index );
 
@@ -629,32 +678,91 @@ Qt::ItemFlags BaseModel::flags( const QModelIndex & index ) const
 
 bool BaseModel::loadFromFile( const QString & file )
 {
-	QFile f( file );
-	QFileInfo finfo( f );
+	std::unique_ptr<QFile> f( new QFile( file ) );
+	QFileInfo finfo( *f );
 
 	setState( Loading );
 
-	if ( f.exists() && finfo.isFile() && f.open( QIODevice::ReadOnly ) && load( f ) ) {
+	bool loaded = false;
+
+	if ( f->exists() && finfo.isFile() && f->open( QIODevice::ReadOnly ) ) {
+		QSettings settings;
+		uchar * map = nullptr;
+
+		if ( settings.value( "Memory Map Files", false ).toBool() && f->size() > 0 && f->size() < INT_MAX )
+			map = f->map( 0, f->size() );
+
+		if ( map ) {
+			QBuffer buf;
+			buf.setData( QByteArray::fromRawData( reinterpret_cast<const char *>( map ), int( f->size() ) ) );
+			buf.open( QIODevice::ReadOnly );
+
+			mappedBuffer = &buf;
+			loaded = load( buf );
+			mappedBuffer = nullptr;
+
+			// load() has cleared the items of the previous file, so its mapping can go
+			mappedFile = std::move( f );
+		} else {
+			loaded = load( *f );
+			mappedFile.reset();
+		}
+	}
+
+	if ( loaded ) {
 		fileinfo = finfo;
 		filename = finfo.baseName();
 		folder = finfo.absolutePath();
-		resetState();
-		return true;
 	}
 
 	resetState();
-	return false;
+	return loaded;
+}
+
+//! Deep copy byte arrays which were read from a memory mapped file
+static void detachMapping( NifItem * item )
+{
+	if ( NifItemLoader * loader = item->deferredLoader() ) {
+		loader->detach();
+		return;
+	}
+
+	if ( item->isPacked() )
+		return;
+
+	if ( QByteArray * array = item->value().get<QByteArray *>() )
+		array->detach();
+
+	for ( NifItem * c : item->children() )
+		detachMapping( c );
+}
+
+void BaseModel::releaseMapping()
+{
+	if ( !mappedFile )
+		return;
+
+	detachMapping( root );
+	mappedFile.reset();
 }
 
-bool BaseModel::saveToFile( const QString & str ) const
+bool BaseModel::saveToFile( const QString & str )
 {
-	QFile f( str );
-	QBuffer buf;
-	bool success = false;
-	if ( buf.open( QIODevice::WriteOnly ) && save( buf ) )
-		success = f.open( QIODevice::WriteOnly ) && f.write( buf.data() ) > 0;
+	// The file cannot be rewritten while data still refers to its mapping
+	if ( mappedFile && QFileInfo( str ) == QFileInfo( *mappedFile ) )
+		releaseMapping();
+
+	// The data is written to a temporary file which only replaces the file once all of it was written
+	QSaveFile f( str );
+	if ( !f.open( QIODevice::WriteOnly ) )
+		return false;
 
-	return success;
+	if ( !save( f ) ) {
+		f.cancelWriting();
+		return false;
+	}
+
+	return f.commit();
 }
 
 void BaseModel::refreshFileInfo( const QString & f )
@@ -684,14 +792,15 @@ NifItem * BaseModel::getItem( NifItem * item, const QString & name ) const
 		return getItem( getItem( item, left ), right );
 	}
 
-	for ( int c = 0; c < item->childCount(); c++ ) {
-		NifItem * child = item->child( c );
+	return getItem( item, NifFieldId::find( name ) );
+}
 
-		if ( child->name() == name && evalCondition( child ) )
-			return child;
-	}
+NifItem * BaseModel::getItem( NifItem * item, const NifFieldId & field ) const
+{
+	if ( !item || item == root || !field.isValid() )
+		return nullptr;
 
-	return nullptr;
+	return item->child( field, [this]( NifItem * child ) { return evalCondition( child ); } );
 }
 
 /*
@@ -743,6 +852,21 @@ QModelIndex BaseModel::getIndex( const QModelIndex & parent, const QString & nam
 	return QModelIndex();
 }
 
+QModelIndex BaseModel::getIndex( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
+
+	if ( !( parent.isValid() && parentItem && parent.model() == this ) )
+		return QModelIndex();
+
+	NifItem * item = getItem( parentItem, field );
+
+	if ( item )
+		return createIndex( item->row(), 0, item );
+
+	return QModelIndex();
+}
+
 /*
  *  conditions and version
  */
@@ -823,62 +947,82 @@ BaseModelEval::BaseModelEval( const BaseModel * model, const NifItem * item )
 
 QVariant BaseModelEval::operator()(const QVariant & v) const
 {
-	if ( v.type() == QVariant::String ) {
-		QString left = v.toString();
-		const NifItem * i = item;
+	if ( v.type() == QVariant::String )
+		return QVariant( resolve( v.toString() ) );
 
-		// resolve "ARG"
-		while ( left == "ARG" ) {
-			if ( !i->parent() )
-				return false;
+	return v;
+}
 
-			i = i->parent();
-			left = i->arg();
-		}
+quint32 BaseModelEval::operator()( const NifExpr::Symbol & sym ) const
+{
+	if ( !sym.field.isValid() )
+		return resolve( sym.name );
 
-		// resolve reference to sibling
-		const NifItem * sibling = model->getItem( i->parent(), left );
-
-		if ( sibling ) {
-			if ( sibling->value().isCount() || sibling->value().isFloat() ) {
-				return QVariant( sibling->value().toCount() );
-			} else if ( sibling->value().isFileVersion() ) {
-				return QVariant( sibling->value().toFileVersion() );
-			// this is tricky to understand
-			// we check whether the reference is an array
-			// if so, we get the current item's row number (i->row())
-			// and get the sibling's child at that row number
-			// this is used for instance to describe array sizes of strips
-			} else if ( sibling->childCount() > 0 ) {
-				const NifItem * i2 = sibling->child( i->row() );
-
-				if ( i2 && i2->value().isCount() )
-					return QVariant( i2->value().toCount() );
-			} else {
-				if ( sibling->value().type() == NifValue::tBSVertexDesc )
-					return QVariant( sibling->value().get<BSVertexDesc>().GetFlags() << 4 );
-
-				qDebug() << ("can't convert " + left + " to a count");
-			}
-		}
+	return resolve( item, model->getItem( item->parent(), sym.field ), sym.name );
+}
 
-		// resolve reference to block type
-		// is the condition string a type?
-		if ( model->isAncestorOrNiBlock( left ) ) {
-			// get the type of the current block
-			const NifItem * block = i;
+quint32 BaseModelEval::resolve( const QString & name ) const
+{
+	QString left = name;
+	const NifItem * i = item;
 
-			while ( block->parent() && block->parent()->parent() ) {
-				block = block->parent();
-			}
+	// resolve "ARG"
+	while ( left == "ARG" ) {
+		if ( !i->parent() )
+			return 0;
 
-			return QVariant( model->inherits( block->name(), left ) );
+		i = i->parent();
+		left = i->arg();
+	}
+
+	// resolve reference to sibling
+	return resolve( i, model->getItem( i->parent(), left ), left );
+}
+
+quint32 BaseModelEval::resolve( const NifItem * i, const NifItem * sibling, const QString & name ) const
+{
+	if ( sibling ) {
+		if ( sibling->value().isCount() || sibling->value().isFloat() ) {
+			return sibling->value().toCount();
+		} else if ( sibling->value().isFileVersion() ) {
+			return sibling->value().toFileVersion();
+		// this is tricky to understand
+		// we check whether the reference is an array
+		// if so, we get the current item's row number (i->row())
+		// and get the sibling's child at that row number
+		// this is used for instance to describe array sizes of strips
+		} else if ( sibling->isPacked() ) {
+			NifValue v = sibling->packedValue( i->row() );
+
+			if ( v.isCount() )
+				return v.toCount();
+		} else if ( sibling->childCount() > 0 ) {
+			const NifItem * i2 = sibling->child( i->row() );
+
+			if ( i2 && i2->value().isCount() )
+				return i2->value().toCount();
+		} else {
+			if ( sibling->value().type() == NifValue::tBSVertexDesc )
+				return sibling->value().get<BSVertexDesc>().GetFlags() << 4;
+
+			qDebug() << ("can't convert " + name + " to a count");
 		}
+	}
+
+	// resolve reference to block type
+	// is the condition string a type?
+	if ( model->isAncestorOrNiBlock( name ) ) {
+		// get the type of the current block
+		const NifItem * block = i;
 
-		return QVariant( 0 );
+		while ( block->parent() && block->parent()->parent() ) {
+			block = block->parent();
+		}
+
+		return model->inherits( block->name(), name );
 	}
 
-	return v;
+	return 0;
 }
 
 unsigned DJB1Hash( const char * key, unsigned tableSize )
@@ -36,8 +36,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "data/nifitem.h"
 
 #include <QAbstractItemModel> // Inherited
+#include <QFile>
 #include <QFileInfo>
 #include <QIODevice>
+#include <QMutex>
 #include <QStack>
 #include <QString>
 #include <QVariant>
@@ -55,6 +57,7 @@ unsigned DJB1Hash( const char * key, unsigned tableSize = UINT_MAX );
 
 class TestMessage;
 class QAbstractItemDelegate;
+class QBuffer;
 
 class NifIStream;
 class NifOStream;
@@ -99,6 +102,10 @@ public:
 	template <typename T> bool set( const QModelIndex & index, const T & d );
 	//! Set an item by name.
 	template <typename T> bool set( const QModelIndex & parent, const QString & name, const T & v );
+	//! Get an item by field ID.
+	template <typename T> T get( const QModelIndex & parent, const NifFieldId & field ) const;
+	//! Set an item by field ID.
+	template <typename T> bool set( const QModelIndex & parent, const NifFieldId & field, const T & v );
 
 	//! Get a model index array as a QVector.
 	template <typename T> QVector<T> getArray( const QModelIndex & iArray ) const;
@@ -110,11 +117,19 @@ public:
 	template <typename T> void setArray( const QModelIndex & iArray, const T & val );
 	//! Write a QVector to a model index array by name.
 	template <typename T> void setArray( const QModelIndex & iArray, const QString & name, const QVector<T> & array );
+	//! Get a model index array as a QVector by field ID.
+	template <typename T> QVector<T> getArray( const QModelIndex & iArray, const NifFieldId & field ) const;
+	//! Write a QVector to a model index array by field ID.
+	template <typename T> void setArray( const QModelIndex & iArray, const NifFieldId & field, const QVector<T> & array );
 
-	//! Load from file.
+	/*! Load from file.
+	 *
+	 * With the "Memory Map Files" setting the file is mapped instead of read, and
+	 * binary data refers to the mapping until it is changed or the file is saved over.
+	 */
 	bool loadFromFile( const QString & filename );
 	//! Save to file.
-	bool saveToFile( const QString & str ) const;
+	bool saveToFile( const QString & str );
 
 	/*! If the model was loaded from a file then getFolder returns the folder.
 	 *
@@ -197,6 +212,8 @@ public:
 
 	//! Find a branch by name.
 	QModelIndex getIndex( const QModelIndex & parent, const QString & name ) const;
+	//! Find a branch by field ID.
+	QModelIndex getIndex( const QModelIndex & parent, const NifFieldId & field ) const;
 
 	//! Evaluate condition and version.
 	bool evalCondition( const QModelIndex & idx, bool chkParents = false ) const;
@@ -225,9 +242,9 @@ public:
 	//! Get the model's state
 	ModelState getState() const { return state; }
 	//! Set the model's state
-	void setState( ModelState s ) const { states.push( state ); state = s; }
+	void setState( ModelState s ) const { if ( concurrentLoad ) return; states.push( state ); state = s; }
 	//! Restore the model's state to the previous
-	void restoreState() const { state = states.pop(); }
+	void restoreState() const { if ( concurrentLoad ) return; state = states.pop(); }
 	//! Reset the model's state
 	void resetState() const { state = Default; states.clear(); }
 	//! Were there updates while batch processing (also clears the result)
@@ -264,6 +281,8 @@ public:
 
 	//! Finds the number of rows
 	int rowCount( const QModelIndex & parent = QModelIndex() ) const override;
+	//! Whether there are rows, without creating the rows of deferred items
+	bool hasChildren( const QModelIndex & parent = QModelIndex() ) const override;
 	//! Finds the number of columns
 	int columnCount( const QModelIndex & parent = QModelIndex() ) const override { Q_UNUSED( parent ); return NumColumns; }
 
@@ -312,12 +331,19 @@ signals:
 protected:
 	//! Get an item
 	virtual NifItem * getItem( NifItem * parent, const QString & name ) const;
+	//! Get an item by field ID
+	virtual NifItem * getItem( NifItem * parent, const NifFieldId & field ) const;
 	//! Set an item value
 	virtual bool setItemValue( NifItem * item, const NifValue & v ) = 0;
 
 	//! Update an array item
 	virtual bool updateArrayItem( NifItem * array ) = 0;
 
+	//! Called before the value of an item is changed
+	virtual void itemChanging( NifItem * item ) { Q_UNUSED( item ); }
+	//! Called when the value, the rows or the schema of an item were changed
+	virtual void itemChanged( NifItem * item ) { Q_UNUSED( item ); }
+
 	//! Convert a version number to a string
 	virtual QString ver2str( quint32 ) const = 0;
 	//! Convert a version string to a number
@@ -339,6 +365,11 @@ protected:
 	//! Set an item
 	template <typename T> bool set( NifItem * item, const T & d );
 
+	//! Get an item by field ID
+	template <typename T> T get( NifItem * parent, const NifFieldId & field ) const;
+	//! Set an item by field ID
+	template <typename T> bool set( NifItem * parent, const NifFieldId & field, const T & d );
+
 	//! Get the size of an array
 	int getArraySize( NifItem * array ) const;
 	//! Evaluate a string for an array
@@ -364,6 +395,8 @@ protected:
 	//! NifSkope window the model belongs to
 	QWidget * parentWindow;
 
+	//! The pool the items are allocated from, null to allocate them from the heap
+	NifItemPool * itemPool = nullptr;
 	//! The root item
 	NifItem * root;
 
@@ -374,11 +407,21 @@ protected:
 	//! The file info for the model
 	QFileInfo fileinfo;
 
+	//! The memory mapped file the model was loaded from, if any
+	std::unique_ptr<QFile> mappedFile;
+	//! The buffer over the mapping while it is being loaded
+	const QBuffer * mappedBuffer = nullptr;
+
+	//! Copy any data which refers to the memory mapped file and unmap it
+	virtual void releaseMapping();
+
 	// Whether or not to emit dataChanged() in set<T>
 	bool emitChanges = true;
 
 	//! A list of test messages
 	mutable QList<TestMessage> messages;
+	//! Guards the test messages while blocks are loaded concurrently
+	mutable QMutex messageLock;
 	//! Handle a test message
 	void testMsg( const QString & m ) const;
 
@@ -388,6 +431,9 @@ protected:
 	mutable ModelState state = Default;
 	mutable QStack<ModelState> states;
 
+	//! Blocks are being decoded on worker threads, which leave the state and row signals alone
+	bool concurrentLoad = false;
+
 	//! Has any data changed while processing
 	bool changedWhileProcessing = false;
 };
@@ -402,8 +448,15 @@ public:
 
 	//! Evaluation function
 	QVariant operator()( const QVariant & v ) const;
+	//! Evaluation function for compiled expressions
+	quint32 operator()( const NifExpr::Symbol & sym ) const;
 
 private:
+	//! Resolves an identifier to a sibling count, version or block type test
+	quint32 resolve( const QString & name ) const;
+	//! Resolves a sibling found from item i
+	quint32 resolve( const NifItem * i, const NifItem * sibling, const QString & name ) const;
+
 	const BaseModel * model;
 	const NifItem * item;
 };
@@ -461,6 +514,56 @@ template <typename T> inline bool BaseModel::set( const QModelIndex & parent, co
 	return false;
 }
 
+template <typename T> inline T BaseModel::get( NifItem * parent, const NifFieldId & field ) const
+{
+	NifItem * item = getItem( parent, field );
+
+	if ( item )
+		return item->value().get<T>();
+
+	return T();
+}
+
+template <typename T> inline T BaseModel::get( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
+
+	if ( !( parent.isValid() && parentItem && parent.model() == this ) )
+		return T();
+
+	NifItem * item = getItem( parentItem, field );
+
+	if ( item )
+		return item->value().get<T>();
+
+	return T();
+}
+
+template <typename T> inline bool BaseModel::set( NifItem * parent, const NifFieldId & field, const T & d )
+{
+	NifItem * item = getItem( parent, field );
+
+	if ( item )
+		return set( item, d );
+
+	return false;
+}
+
+template <typename T> inline bool BaseModel::set( const QModelIndex & parent, const NifFieldId & field, const T & d )
+{
+	NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
+
+	if ( !( parent.isValid() && parentItem && parent.model() == this ) )
+		return false;
+
+	NifItem * item = getItem( parentItem, field );
+
+	if ( item )
+		return set( item, d );
+
+	return false;
+}
+
 template <typename T> inline T BaseModel::get( NifItem * item ) const
 {
 	return item->value().get<T>();
@@ -478,7 +581,11 @@ template <typename T> inline T BaseModel::get( const QModelIndex & index ) const
 
 template <typename T> inline bool BaseModel::set( NifItem * item, const T & d )
 {
+	itemChanging( item );
+
 	if ( item->value().set( d ) ) {
+		itemChanged( item );
+
 		if ( state != Processing )
 			emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
 		else
@@ -515,15 +622,23 @@ template <typename T> inline QVector<T> BaseModel::getArray( const QModelIndex &
 	return getArray<T>( getIndex( iParent, name ) );
 }
 
+template <typename T> inline QVector<T> BaseModel::getArray( const QModelIndex & iParent, const NifFieldId & field ) const
+{
+	return getArray<T>( getIndex( iParent, field ) );
+}
+
 template <typename T> inline void BaseModel::setArray( const QModelIndex & iArray, const QVector<T> & array )
 {
 	NifItem * item = static_cast<NifItem *>( iArray.internalPointer() );
 
 	if ( isArray( iArray ) && item && iArray.model() == this ) {
 		item->setArray<T>( array );
+		itemChanged( item );
 		int x = item->childCount() - 1;
 
-		if ( x >= 0 )
+		if ( item->isPacked() )
+			emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
+		else if ( x >= 0 )
 			emit dataChanged( createIndex( 0, ValueCol, item->child( 0 ) ), createIndex( x, ValueCol, item->child( x ) ) );
 	}
 }
@@ -534,9 +649,12 @@ template <typename T> inline void BaseModel::setArray( const QModelIndex & iArra
 
 	if ( isArray( iArray ) && item && iArray.model() == this ) {
 		item->setArray<T>( val );
+		itemChanged( item );
 		int x = item->childCount() - 1;
 
-		if ( x >= 0 )
+		if ( item->isPacked() )
+			emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
+		else if ( x >= 0 )
 			emit dataChanged( createIndex( 0, ValueCol, item->child( 0 ) ), createIndex( x, ValueCol, item->child( x ) ) );
 	}
 }
@@ -546,4 +664,9 @@ template <typename T> inline void BaseModel::setArray( const QModelIndex & iPare
 	setArray<T>( getIndex( iParent, name ), array );
 }
 
+template <typename T> inline void BaseModel::setArray( const QModelIndex & iParent, const NifFieldId & field, const QVector<T> & array )
+{
+	setArray<T>( getIndex( iParent, field ), array );
+}
+
 #endif
@@ -114,8 +114,11 @@ protected:
 	static QHash<QString, NifBlockPtr> compounds;
 
 	static QString parseXmlDescription( const QString & filename );
+	static bool readSchema( QDataStream & ds );
+	static void writeSchema( QDataStream & ds );
 
 	friend class KfmXmlHandler;
+	friend class Benchmark;
 }; // class NifModel
 
 
@@ -37,11 +37,15 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "data/niftypes.h"
 #include "io/nifstream.h"
 
+#include <QBuffer>
 #include <QByteArray>
 #include <QColor>
 #include <QDebug>
 #include <QFile>
+#include <QMutex>
+#include <QRunnable>
 #include <QSettings>
+#include <QThreadPool>
 
 
 
@@ -172,6 +176,13 @@ bool NifModel::evalVersion( NifItem * item, bool chkParents ) const
 	if ( item->versionCondition() )
 		return true;
 
+	// Version conditions only read the header, so each is evaluated once per header
+	int id = item->vercondId();
+	if ( headerConditionsValid && id >= 0 && id < headerConditions.size() ) {
+		item->setVersionCondition( headerConditions.testBit( id ) );
+		return item->versionCondition();
+	}
+
 	// If there is a vercond, evaluate it
 	NifModelEval functor( this, getHeaderItem() );
 	item->setVersionCondition( item->verexpr().evaluateBool( functor ) );
@@ -186,6 +197,10 @@ void NifModel::clear()
 	filename = QString();
 	folder = QString();
 	root->killChildren();
+	rootsPending = false;
+	cleanBlocks.clear();
+	rowSizes.clear();
+	rowOffsets.clear();
 
 	NifData headerData = NifData( "NiHeader", "Header" );
 	NifData footerData = NifData( "NiFooter", "Footer" );
@@ -193,6 +208,10 @@ void NifModel::clear()
 	headerData.setIsConditionless( true );
 	footerData.setIsCompound( true );
 	footerData.setIsConditionless( true );
+	if ( NifBlockPtr header = compounds.value( "Header" ) )
+		headerData.setFieldRows( header->fieldRows );
+	if ( NifBlockPtr footer = compounds.value( "Footer" ) )
+		footerData.setFieldRows( footer->fieldRows );
 
 	insertType( root, headerData );
 	insertType( root, footerData );
@@ -237,6 +256,8 @@ void NifModel::clear()
 		setArray<QString>( getHeader(), "Copyright", copyright );
 	}
 
+	updateHeaderConditions();
+
 	lockUpdates = false;
 	needUpdates = utNone;
 }
@@ -359,9 +380,12 @@ void NifModel::updateHeader()
 		QVector<int> blocktypeindices;
 		QVector<int> blocksizes;
 
+		checkBlockFormat();
+
 		for ( int r = 1; r < root->childCount() - 1; r++ ) {
 			NifItem * block = root->child( r );
-			QString blockName = createRTTIName( block );
+			auto deferred = static_cast<NifBlockLoader *>( block->deferredLoader() );
+			QString blockName = deferred ? deferred->rttiName : createRTTIName( block );
 
 			int bTypeIdx = blocktypes.indexOf( blockName );
 			if ( bTypeIdx < 0 ) {
@@ -372,8 +396,11 @@ void NifModel::updateHeader()
 			blocktypeindices.append( bTypeIdx );
 
 			if ( version >= 0x14020000 && idxBlockSize ) {
-				updateArrays( block );
-				blocksizes.append( blockSize( block ) );
+				// Only blocks changed since their size was last known are walked
+				if ( !deferred && !cleanBlocks.contains( block ) && !rowSizes.contains( block ) )
+					updateArrays( block );
+
+				blocksizes.append( rowSize( block ) );
 			}
 
 		}
@@ -449,12 +476,15 @@ NifItem * NifModel::getItem( NifItem * item, const QString & name ) const
 		}
 	}
 
-	for ( auto child : item->children() ) {
-		if ( child && child->name() == name && evalCondition( child ) )
-			return child;
-	}
+	return getItem( item, NifFieldId::find( name ) );
+}
 
-	return nullptr;
+NifItem * NifModel::getItem( NifItem * item, const NifFieldId & field ) const
+{
+	if ( !item || item == root || !field.isValid() )
+		return nullptr;
+
+	return item->child( field, [this]( NifItem * child ) { return evalCondition( child ); } );
 }
 
 /*
@@ -471,6 +501,97 @@ static QString parentPrefix( const QString & x )
 	return x;
 }
 
+//! Data derived from the fields of items, keyed by the shared data of the field and what was derived
+struct DerivedData
+{
+	QMutex lock;
+	//! The field is kept with its derived data so that its shared data is never freed and reused for another key
+	QHash<QPair<const NifSharedData *, QString>, QPair<NifData, NifData>> data;
+};
+
+//! Function local so that it is safe to use from the load threads before any model exists
+static DerivedData & derivedData()
+{
+	static DerivedData d;
+	return d;
+}
+
+// documented in nifmodel.h
+NifData NifModel::arrayRowData( const NifData & array, bool binary )
+{
+	DerivedData & derived = derivedData();
+	QMutexLocker lck( &derived.lock );
+
+	auto key = qMakePair( array.shared(), binary ? QStringLiteral( "[binary]" ) : QStringLiteral( "[]" ) );
+	auto it = derived.data.constFind( key );
+	if ( it != derived.data.constEnd() )
+		return it.value().second;
+
+	NifData data;
+	if ( binary ) {
+		data = NifData( array.name(), array.type(), array.temp(), NifValue( NifValue::tBlob ), parentPrefix( array.arg() ) );
+		data.setBinary( true );
+	} else {
+		data = NifData( array.name(),
+						array.type(),
+						array.temp(),
+						NifValue( NifValue::type( array.type() ) ),
+						parentPrefix( array.arg() ),
+						parentPrefix( array.arr2() ) // arr1 in children is parent arr2
+		);
+
+		// Fill data flags
+		data.setIsConditionless( true );
+		data.setIsCompound( array.isCompound() );
+		data.setIsArray( array.isMultiArray() );
+		data.setFieldRows( array.fieldRows() );
+	}
+
+	derived.data.insert( key, qMakePair( array, data ) );
+	return data;
+}
+
+// documented in nifmodel.h
+NifData NifModel::templateData( const NifData & data, const QString & tmp )
+{
+	DerivedData & derived = derivedData();
+	QMutexLocker lck( &derived.lock );
+
+	auto key = qMakePair( data.shared(), tmp );
+	auto it = derived.data.constFind( key );
+	if ( it != derived.data.constEnd() )
+		return it.value().second;
+
+	QLatin1String tmpl( "TEMPLATE" );
+	NifData d( data );
+
+	if ( d.type() == tmpl ) {
+		d.value.changeType( NifValue::type( tmp ) );
+		d.setType( tmp );
+		// The templates are now filled
+		d.setTemplated( false );
+
+		// The row table of a compound filled in for the template is attached here, once for all its instances
+		if ( NifBlockPtr compound = compounds.value( tmp ) )
+			d.setFieldRows( compound->fieldRows );
+	}
+
+	if ( d.temp() == tmpl )
+		d.setTemp( tmp );
+
+	derived.data.insert( key, qMakePair( data, d ) );
+	return d;
+}
+
+// documented in nifmodel.h
+void NifModel::clearDerivedData()
+{
+	DerivedData & derived = derivedData();
+	QMutexLocker lck( &derived.lock );
+
+	derived.data.clear();
+}
+
 bool NifModel::updateByteArrayItem( NifItem * array )
 {
 	// New row count
@@ -502,8 +623,7 @@ bool NifModel::updateByteArrayItem( NifItem * array )
 
 	// Create the dummy row for holding the byte array
 	if ( itemRows == 0 ) {
-		NifData data( array->name(), array->type(), array->temp(), NifValue( NifValue::tBlob ), parentPrefix( array->arg() ) );
-		data.setBinary( true );
+		NifData data = arrayRowData( array->data(), true );
 
 		beginInsertRows( createIndex( array->row(), 0, array ), 0, 1 );
 
@@ -520,8 +640,11 @@ bool NifModel::updateByteArrayItem( NifItem * array )
 			set<QByteArray>( child, bytes );
 		} else if ( bm->size() == 0 ) {
 			*bm = bytes;
-		} else {
+			itemChanged( child );
+		} else if ( bm->size() != rows ) {
+			// Resizing would copy data referring to a memory mapped file
 			bm->resize( rows );
+			itemChanged( child );
 		}
 	}
 
@@ -567,27 +690,22 @@ bool NifModel::updateArrayItem( NifItem * array )
 	// Previous row count
 	int itemRows = array->childCount();
 
+	// Arrays of plain values are kept packed until their rows are accessed
+	bool pack = !array->isCompound() && !array->isMultiArray() && ( itemRows == 0 || array->isPacked() );
+
 	// Add item children
 	if ( rows > itemRows ) {
-		NifData data( array->name(),
-					  array->type(),
-					  array->temp(),
-					  NifValue( NifValue::type( array->type() ) ),
-					  parentPrefix( array->arg() ),
-					  parentPrefix( array->arr2() ) // arr1 in children is parent arr2
-		);
-
-		// Fill data flags
-		data.setIsConditionless( true );
-		data.setIsCompound( array->isCompound() );
-		data.setIsArray( array->isMultiArray() );
+		// Every row shares the data of the rows of arrays of the same field
+		NifData data = arrayRowData( array->data(), false );
 
 		beginInsertRows( createIndex( array->row(), 0, array ), itemRows, rows - 1 );
 
-		array->prepareInsert( rows - itemRows );
+		if ( !pack || !array->resizePacked( rows, data ) ) {
+			array->prepareInsert( rows - itemRows );
 
-		for ( int c = itemRows; c < rows; c++ )
-			insertType( array, data );
+			for ( int c = itemRows; c < rows; c++ )
+				insertType( array, data );
+		}
 
 		endInsertRows();
 	}
@@ -596,7 +714,10 @@ bool NifModel::updateArrayItem( NifItem * array )
 	if ( rows < itemRows ) {
 		beginRemoveRows( createIndex( array->row(), 0, array ), rows, itemRows - 1 );
 
-		array->removeChildren( rows, itemRows - rows );
+		if ( array->isPacked() )
+			array->resizePacked( rows, array->packedArray()->element );
+		else
+			array->removeChildren( rows, itemRows - rows );
 
 		endRemoveRows();
 	}
@@ -622,6 +743,9 @@ bool NifModel::updateArrays( NifItem * parent )
 	if ( !parent )
 		return false;
 
+	if ( parent->isPacked() )
+		return true;
+
 	for ( auto child : parent->children() ) {
 		if ( evalCondition( child ) ) {
 			if ( isArray( child ) ) {
@@ -659,19 +783,12 @@ QModelIndex NifModel::insertNiBlock( const QString & identifier, int at )
 
 		beginInsertRows( QModelIndex(), at, at );
 
-		NifItem * branch = insertBranch( root, NifData( identifier, "NiBlock", block->text ), at );
+		NifItem * branch = insertBranch( root, block->data, at );
 		branch->setCondition( true );
 
 		endInsertRows();
 
-		if ( !block->ancestor.isEmpty() )
-			insertAncestor( branch, block->ancestor );
-
-		branch->prepareInsert( block->types.count() );
-
-		for ( const NifData& data : block->types ) {
-			insertType( branch, data );
-		}
+		insertBlockFields( branch, block );
 
 		if ( state != Loading ) {
 			updateHeader();
@@ -746,7 +863,7 @@ void NifModel::moveNiBlock( int src, int dst )
 
 void NifModel::updateStrings( NifModel * src, NifModel * tgt, NifItem * item )
 {
-	if ( !item )
+	if ( !item || item->isPacked() )
 		return;
 
 	NifValue::Type vt = item->value().type();
@@ -769,6 +886,9 @@ QMap<qint32, qint32> NifModel::moveAllNiBlocks( NifModel * targetnif, bool updat
 
 	QMap<qint32, qint32> map;
 
+	// Deferred blocks are decoded by the model they were read by, so no loader may move with its block
+	loadDeferredBlocks( 1 );
+
 	beginRemoveRows( QModelIndex(), 1, bcnt );
 	targetnif->beginInsertRows( QModelIndex(), targetnif->getBlockCount(), targetnif->getBlockCount() + bcnt - 1 );
 
@@ -1112,19 +1232,7 @@ void NifModel::insertType( NifItem * parent, const NifData & data, int at )
 			tmp = tItem->temp();
 		}
 
-		NifData d( data );
-
-		if ( d.type() == tmpl ) {
-			d.value.changeType( NifValue::type( tmp ) );
-			d.setType( tmp );
-			// The templates are now filled
-			d.setTemplated( false );
-		}
-
-		if ( d.temp() == tmpl )
-			d.setTemp( tmp );
-
-		insertType( parent, d, at );
+		insertType( parent, templateData( data, tmp ), at );
 	} else {
 		NifItem * item = parent->insertChild( data, at );
 
@@ -1145,7 +1253,9 @@ void NifModel::insertType( NifItem * parent, const NifData & data, int at )
 
 bool NifModel::setItemValue( NifItem * item, const NifValue & val )
 {
+	itemChanging( item );
 	item->value() = val;
+	itemChanged( item );
 	emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
 
 	if ( itemIsLink( item ) ) {
@@ -1548,6 +1658,7 @@ bool NifModel::setData( const QModelIndex & index, const QVariant & value, int r
 		break;
 	case NifModel::ValueCol:
 		{
+			itemChanging( item );
 			NifValue & val = item->value();
 
 			if ( val.type() == NifValue::tString || val.type() == NifValue::tFilePath ) {
@@ -1588,6 +1699,8 @@ bool NifModel::setData( const QModelIndex & index, const QVariant & value, int r
 		return false;
 	}
 
+	itemChanged( item );
+
 	// reverse buddy lookup
 	if ( index.column() == ValueCol ) {
 		if ( item->name() == "File Name" ) {
@@ -1766,6 +1879,8 @@ bool NifModel::load( QIODevice & device )
 {
 	QSettings settings;
 	bool ignoreSize = settings.value( "Ignore Block Size", true ).toBool();
+	bool deferBlocks = settings.value( "Defer Block Loading", false ).toBool();
+	int loadThreads = settings.value( "Load Threads", 1 ).toInt();
 
 	clear();
 
@@ -1792,6 +1907,16 @@ bool NifModel::load( QIODevice & device )
 	numblocks = get<int>( header, "Num Blocks" );
 	//qDebug( "numblocks %i", numblocks );
 
+	// Blocks can only be split up front when their sizes are known, and kept undecoded when
+	//	their bytes can be written back as is. Otherwise they are decoded serially as they are read.
+	bool splitBlocks = deferBlocks || loadThreads > 1;
+	if ( splitBlocks ) {
+		NifItem * endian = getItem( header, "Endian Type" );
+		splitBlocks = version >= 0x14020007 && getItem( header, "Block Size" )
+			&& !( endian && endian->value().toCount() == 0 );
+	}
+	deferBlocks = deferBlocks && splitBlocks;
+
 	emit sigProgress( 0, numblocks );
 	//QTime t = QTime::currentTime();
 
@@ -1800,6 +1925,11 @@ bool NifModel::load( QIODevice & device )
 	{
 		curpos = device.pos();
 
+		// Block sizes are also used to keep the bytes of unchanged blocks when they are not checked
+		QModelIndex iBlockSize;
+		if ( version >= 0x14020000 )
+			iBlockSize = getIndex( createIndex( header->row(), 0, header ), "Block Size" );
+
 		if ( version >= 0x0303000d ) {
 			// read in the NiBlocks
 			QString prevblktyp;
@@ -1812,6 +1942,7 @@ bool NifModel::load( QIODevice & device )
 
 				QString blktyp;
 				quint32 size = UINT_MAX;
+				quint32 blockSize = UINT_MAX;
 				try
 				{
 					if ( version >= 0x0a000000 ) {
@@ -1851,8 +1982,11 @@ bool NifModel::load( QIODevice & device )
 						}
 
 						// for version 20.2.0.? and above the block size is stored in the header
-						if ( !ignoreSize && version >= 0x14020000 )
-							size = get<quint32>( index( c, 0, getIndex( createIndex( header->row(), 0, header ), "Block Size" ) ) );
+						if ( iBlockSize.isValid() ) {
+							blockSize = get<quint32>( index( c, 0, iBlockSize ) );
+							if ( !ignoreSize || splitBlocks )
+								size = blockSize;
+						}
 					} else {
 						int len;
 						device.read( (char *)&len, 4 );
@@ -1865,15 +1999,75 @@ bool NifModel::load( QIODevice & device )
 
 					// Hack for NiMesh data streams
 					NiMesh::DataStreamMetadata metadata = {};
+					QString rtti = blktyp;
 
 					if ( blktyp.startsWith( "NiDataStream\x01" ) )
 						blktyp = extractRTTIArgs( blktyp, metadata );
 
-					if ( isNiBlock( blktyp ) ) {
+					if ( isNiBlock( blktyp ) && splitBlocks ) {
+						// Keep the data of the block; it is decoded when its items are first accessed
+						QByteArray data;
+						qint64 pos = device.pos();
+
+						if ( &device == mappedBuffer ) {
+							const QByteArray & file = mappedBuffer->data();
+							if ( pos + size > file.size() )
+								throw tr( "unexpected EOF during load" );
+
+							data = QByteArray::fromRawData( file.constData() + pos, size );
+							device.seek( pos + size );
+						} else {
+							data = device.read( size );
+							if ( data.size() != int( size ) )
+								throw tr( "unexpected EOF during load" );
+						}
+
+						NifBlockPtr block = blocks.value( blktyp );
+						int at = getBlockCount() + 1;
+						beginInsertRows( QModelIndex(), at, at );
+
+						NifItem * branch = insertBranch( root, block->data, at );
+						branch->setCondition( true );
+						branch->setLoader( new NifBlockLoader( this, rtti, data, metadata ) );
+
+						endInsertRows();
+					} else if ( isNiBlock( blktyp ) ) {
 						//qDebug() << "loading block" << c << ":" << blktyp );
 						QModelIndex newBlock = insertNiBlock( blktyp, -1 );
+						NifItem * block = root->child( c + 1 );
+						qint64 pos = device.pos();
+
+						// Without a mapping, a block of known size is read once and decoded from memory to keep its bytes
+						QByteArray data;
+						bool buffered = &device != mappedBuffer && blockSize != UINT_MAX && pos + blockSize <= device.size();
+						if ( buffered ) {
+							data = device.read( blockSize );
+							buffered = data.size() == int( blockSize );
+							if ( !buffered )
+								device.seek( pos );
+						}
+
+						bool loaded;
+						if ( buffered ) {
+							QBuffer buf( &data );
+							buf.open( QIODevice::ReadOnly );
+
+							NifIStream blockStream( this, &buf );
+							loaded = loadItem( block, blockStream );
+
+							// The rest of the file is read from where decoding ended, as without a buffer
+							if ( loaded && buf.pos() == buf.size() )
+								cleanBlocks.insert( block, data );
+							else
+								device.seek( pos + buf.pos() );
+						} else {
+							loaded = loadItem( block, stream );
 
-						if ( !loadItem( root->child( c + 1 ), stream ) ) {
+							if ( loaded && ( size == UINT_MAX || pos + size == device.pos() ) )
+								keepBlockData( block, device, pos );
+						}
+
+						if ( !loaded ) {
 							NifItem * child = root->child( c );
 							throw tr( "failed to load block number %1 (%2) previous block was %3" ).arg( c ).arg( blktyp ).arg( child ? child->name() : prevblktyp );
 						}
@@ -2014,26 +2208,211 @@ bool NifModel::load( QIODevice & device )
 	}
 
 	//qDebug() << t.msecsTo( QTime::currentTime() );
+	cleanFormat = blockFormat();
+
+	if ( deferBlocks ) {
+		// Links of deferred blocks are collected as they are decoded, so take the roots from the footer
+		//	until they are asked for, see getRootLinks()
+		beginResetModel();
+		resetState();
+		childLinks.clear();
+		parentLinks.clear();
+		rootLinks.clear();
+		for ( const auto l : getLinkArray( getFooter(), "Roots" ) )
+			rootLinks.append( l );
+		rootsPending = true;
+		endResetModel();
+		reportMemoryUsage();
+		return true;
+	}
+
+	if ( splitBlocks )
+		loadDeferredBlocks( loadThreads );
+
 	reset(); // notify model views that a significant change to the data structure has occurded
+	reportMemoryUsage();
 	return true;
 }
 
+void NifModel::reportMemoryUsage() const
+{
+	if ( !nsNif().isDebugEnabled() )
+		return;
+
+	qint64 items = 0, bytes = 0;
+	root->memoryUsage( items, bytes );
+
+	qCDebug( nsNif ) << tr( "%1: %2 items, %3 bytes per item" ).arg( fileinfo.fileName() ).arg( items )
+		.arg( double( bytes ) / qMax( items, qint64( 1 ) ), 0, 'f', 1 );
+}
+
+//! Caches the conditions of an item and of its fields outside of arrays
+static void cacheConditions( const NifModel * model, NifItem * item )
+{
+	model->evalCondition( item, true );
+
+	if ( item->isArray() )
+		return;
+
+	for ( NifItem * child : item->children() )
+		cacheConditions( model, child );
+}
+
+//! Decodes one deferred block on a thread pool
+class BlockLoadTask final : public QRunnable
+{
+public:
+	BlockLoadTask( NifItem * b ) : block( b ) {}
+
+	void run() override final { block->materialize(); }
+
+private:
+	NifItem * block;
+};
+
+void NifModel::loadDeferredBlocks( int threads )
+{
+	QVector<NifItem *> deferred;
+	for ( int b = 0; b < getBlockCount(); b++ ) {
+		NifItem * block = getBlockItem( b );
+		if ( block->isDeferred() )
+			deferred.append( block );
+	}
+
+	if ( deferred.isEmpty() )
+		return;
+
+	if ( threads <= 1 ) {
+		for ( NifItem * block : deferred )
+			block->materialize();
+		return;
+	}
+
+	// Each block only touches its own items; the state, signals and messages of the model are held still
+	MsgMode mode = msgMode;
+	msgMode = TstMessage;
+	bool blocked = blockSignals( true );
+	concurrentLoad = true;
+
+	// The workers evaluate the conditions of their blocks against the header, so everything they
+	// read outside of their blocks is cached beforehand and is then only read
+	if ( !headerConditionsValid )
+		updateHeaderConditions();
+
+	cacheConditions( this, getHeaderItem() );
+
+	QThreadPool pool;
+	pool.setMaxThreadCount( threads );
+
+	// The data of the blocks is kept here, as the workers cannot share the table of clean blocks
+	QVector<QByteArray> data;
+	data.reserve( deferred.count() );
+
+	for ( NifItem * block : deferred ) {
+		data.append( static_cast<NifBlockLoader *>( block->deferredLoader() )->data );
+		pool.start( new BlockLoadTask( block ) );
+	}
+
+	pool.waitForDone();
+
+	for ( int i = 0; i < deferred.count(); i++ )
+		cleanBlocks.insert( deferred.at( i ), data.at( i ) );
+
+	concurrentLoad = false;
+	blockSignals( blocked );
+	msgMode = mode;
+
+	if ( mode == UserMessage ) {
+		for ( const QString & m : getMessages() )
+			Message::append( tr( "Warnings were generated while reading NIF file." ), m );
+	}
+}
+
+void NifBlockLoader::load( NifItem * block )
+{
+	model->loadDeferredBlock( block, *this );
+}
+
+void NifModel::loadDeferredBlock( NifItem * block, const NifBlockLoader & loader )
+{
+	NifBlockPtr type = blocks.value( block->name() );
+	if ( !type )
+		return;
+
+	// No view has seen the rows of the block yet; signals are already blocked when loading concurrently
+	QSignalBlocker blocker( concurrentLoad ? nullptr : this );
+	setState( Loading );
+
+	insertBlockFields( block, type );
+
+	QBuffer buf;
+	buf.setData( loader.data );
+	buf.open( QIODevice::ReadOnly );
+
+	NifIStream stream( this, &buf );
+	int b = getBlockNumber( block );
+
+	QString m;
+	if ( !loadItem( block, stream ) ) {
+		m = tr( "failed to load block number %1 (%2)" ).arg( b ).arg( block->name() );
+	} else if ( buf.pos() != buf.size() ) {
+		m = tr( "device position incorrect after block number %1 (%2) ended at 0x%3 (expected 0x%4)" )
+			.arg( b )
+			.arg( block->name() )
+			.arg( QString::number( buf.pos(), 16 ) )
+			.arg( QString::number( buf.size(), 16 ) );
+	}
+
+	if ( !m.isEmpty() ) {
+		if ( msgMode == UserMessage ) {
+			Message::append( tr( "Warnings were generated while reading NIF file." ), m );
+		} else {
+			testMsg( m );
+		}
+	}
+
+	// NiMesh hack
+	if ( block->name() == "NiDataStream" ) {
+		set<quint32>( block, "Usage", loader.metadata.usage );
+		set<quint32>( block, "Access", loader.metadata.access );
+	}
+
+	restoreState();
+
+	// Links of all blocks are updated once concurrent loading is done
+	if ( !concurrentLoad ) {
+		cleanBlocks.insert( block, loader.data );
+		updateLinks( b );
+	}
+}
+
 bool NifModel::save( QIODevice & device ) const
 {
 	NifOStream stream( this, &device );
 
 	setState( Saving );
 
+	checkBlockFormat();
+
 	// Force update header and footer prior to save
 	if ( NifModel * mdl = const_cast<NifModel *>(this) ) {
 		mdl->updateHeader();
 		mdl->updateFooter();
 	}
 
-	emit sigProgress( 0, rowCount( QModelIndex() ) );
+	// Progress is reported in percent of the bytes written, as the byte counts of large files do not fit an int
+	qint64 start = device.pos();
+	qint64 total = qMax( fileSize(), qint64( 1 ) );
+	int reported = 0;
+
+	emit sigProgress( 0, 100 );
 
 	for ( int c = 0; c < rowCount( QModelIndex() ); c++ ) {
-		emit sigProgress( c + 1, rowCount( QModelIndex() ) );
+		int percent = int( ( device.pos() - start ) * 100 / total );
+		if ( percent > reported ) {
+			emit sigProgress( percent, 100 );
+			reported = percent;
+		}
 
 		//qDebug() << "saving block " << c << ": " << itemName( index( c, 0 ) );
 
@@ -2064,7 +2443,19 @@ bool NifModel::save( QIODevice & device ) const
 			}
 		}
 
-		if ( !saveItem( root->child( c ), stream ) ) {
+		bool saved;
+		NifItem * block = root->child( c );
+		auto deferred = static_cast<NifBlockLoader *>( block->deferredLoader() );
+
+		// A block that was never decoded is written back as it was read
+		if ( deferred )
+			saved = device.write( deferred->data ) == deferred->data.size();
+		else if ( c > 0 && c <= getBlockCount() )
+			saved = saveBlock( block, device );
+		else
+			saved = saveItem( block, stream );
+
+		if ( !saved ) {
 			Message::critical( nullptr, tr( "Failed to write block %1 (%2)." ).arg( itemName( index( c, 0 ) ) ).arg( c - 1 ) );
 			resetState();
 			return false;
@@ -2078,10 +2469,380 @@ bool NifModel::save( QIODevice & device ) const
 		device.write( string.toLatin1().constData(), len );
 	}
 
+	emit sigProgress( 100, 100 );
+
 	resetState();
 	return true;
 }
 
+qint64 NifModel::fileSize() const
+{
+	updateRowOffsets();
+
+	int last = root->childCount() - 1;
+	return rowOffsets.at( last ) + rowSize( root->child( last ) );
+}
+
+int NifModel::rowSize( NifItem * item ) const
+{
+	if ( auto deferred = static_cast<NifBlockLoader *>( item->deferredLoader() ) )
+		return deferred->data.size();
+
+	auto clean = cleanBlocks.constFind( item );
+	if ( clean != cleanBlocks.constEnd() )
+		return clean.value().size();
+
+	auto known = rowSizes.constFind( item );
+	if ( known != rowSizes.constEnd() )
+		return known.value();
+
+	int size = blockSize( item );
+
+	// Sizes are only invalidated once loading is done
+	if ( state != Loading )
+		rowSizes.insert( item, size );
+
+	return size;
+}
+
+int NifModel::rowPrefixSize( int row ) const
+{
+	if ( row <= 0 || row > getBlockCount() )
+		return 0;
+
+	if ( version > 0x0a000000 )
+		return ( version < 0x0a020000 ) ? 4 : 0;
+
+	int size = 0;
+
+	if ( version < 0x0303000d ) {
+		if ( rootLinks.contains( row - 1 ) )
+			size += 4 + QString( "Top Level Object" ).length();
+
+		size += 4;
+	}
+
+	return size + 4 + itemName( this->NifModel::index( row, 0 ) ).length();
+}
+
+void NifModel::updateRowOffsets() const
+{
+	checkBlockFormat();
+
+	if ( rowOffsets.count() == root->childCount() )
+		return;
+
+	rowOffsets.resize( root->childCount() );
+	qint64 ofs = 0;
+
+	for ( int c = 0; c < root->childCount(); c++ ) {
+		ofs += rowPrefixSize( c );
+		rowOffsets[c] = ofs;
+		ofs += rowSize( root->child( c ) );
+	}
+}
+
+void NifModel::checkBlockFormat() const
+{
+	// Data and sizes kept for another version are of no use
+	if ( cleanFormat != blockFormat() ) {
+		cleanBlocks.clear();
+		rowSizes.clear();
+		rowOffsets.clear();
+		cleanFormat = blockFormat();
+	}
+}
+
+bool NifModel::saveBlock( NifItem * block, QIODevice & device ) const
+{
+	// An unchanged block is written back as it was last read or written
+	auto clean = cleanBlocks.constFind( block );
+	if ( clean != cleanBlocks.constEnd() )
+		return device.write( clean.value() ) == clean.value().size();
+
+	QBuffer buf;
+	buf.open( QIODevice::WriteOnly );
+
+	NifOStream stream( this, &buf );
+	if ( !saveItem( block, stream ) )
+		return false;
+
+	if ( device.write( buf.data() ) != buf.size() )
+		return false;
+
+	cleanBlocks.insert( block, buf.data() );
+	return true;
+}
+
+void NifModel::keepBlockData( NifItem * block, QIODevice & device, qint64 pos )
+{
+	// Only a mapped file can provide the bytes of a block that was decoded without knowing its size
+	if ( &device == mappedBuffer )
+		cleanBlocks.insert( block, QByteArray::fromRawData( mappedBuffer->data().constData() + pos, int( device.pos() - pos ) ) );
+}
+
+void NifModel::itemChanging( NifItem * item )
+{
+	if ( state == Loading || !item )
+		return;
+
+	NifItem * field = item;
+
+	while ( item->parent() && item->parent() != root )
+		item = item->parent();
+
+	if ( item != getHeaderItem() )
+		return;
+
+	// Deferred blocks are decoded while the header still describes the format they were read in
+	if ( versionConditionFields.contains( field->nameId().value() )
+		|| field->name() == "User Version" || field->name() == "User Version 2" )
+	{
+		loadDeferredBlocks( 1 );
+	}
+}
+
+void NifModel::itemChanged( NifItem * item )
+{
+	// Items are only created while loading
+	if ( state == Loading || !item )
+		return;
+
+	rowOffsets.clear();
+
+	// Blocks being added, removed or moved renumber the links of other blocks
+	if ( item == root ) {
+		cleanBlocks.clear();
+		return;
+	}
+
+	int field = item->nameId().value();
+
+	while ( item->parent() && item->parent() != root )
+		item = item->parent();
+
+	cleanBlocks.remove( item );
+	rowSizes.remove( item );
+
+	if ( item == getHeaderItem() && versionConditionFields.contains( field ) )
+		updateHeaderConditions();
+}
+
+void NifModel::releaseMapping()
+{
+	if ( !mappedFile )
+		return;
+
+	// Data shared between the model and its snapshots is copied once
+	QHash<const char *, QByteArray> copies;
+	auto detach = [&copies]( QByteArray & data ) {
+		auto copy = copies.constFind( data.constData() );
+		if ( copy != copies.constEnd() && copy.value().size() == data.size() ) {
+			data = copy.value();
+			return;
+		}
+
+		const char * raw = data.constData();
+		data.detach();
+		copies.insert( raw, data );
+	};
+
+	for ( QByteArray & data : cleanBlocks )
+		detach( data );
+
+	for ( const std::weak_ptr<NifSnapshot> & s : snapshots ) {
+		if ( auto snapshot = s.lock() ) {
+			for ( QByteArray & data : snapshot->rows )
+				detach( data );
+		}
+	}
+
+	BaseModel::releaseMapping();
+}
+
+std::shared_ptr<NifSnapshot> NifModel::takeSnapshot()
+{
+	// The header is brought up to date with the blocks, as when saving
+	updateHeader();
+	updateFooter();
+	checkBlockFormat();
+
+	setState( Saving );
+
+	auto snapshot = std::make_shared<NifSnapshot>();
+	snapshot->types.reserve( getBlockCount() );
+	snapshot->rows.reserve( root->childCount() );
+
+	for ( int c = 0; c < root->childCount(); c++ ) {
+		NifItem * row = root->child( c );
+		bool isBlock = c > 0 && c <= getBlockCount();
+		auto deferred = static_cast<NifBlockLoader *>( row->deferredLoader() );
+
+		if ( isBlock )
+			snapshot->types.append( deferred ? deferred->rttiName : createRTTIName( row ) );
+
+		if ( deferred ) {
+			snapshot->rows.append( deferred->data );
+			continue;
+		}
+
+		// Unchanged blocks share the data they were last read or written with
+		auto clean = cleanBlocks.constFind( row );
+		if ( clean != cleanBlocks.constEnd() ) {
+			snapshot->rows.append( clean.value() );
+			continue;
+		}
+
+		QBuffer buf;
+		buf.open( QIODevice::WriteOnly );
+
+		NifOStream stream( this, &buf );
+		if ( !saveItem( row, stream ) ) {
+			restoreState();
+			return nullptr;
+		}
+
+		if ( isBlock )
+			cleanBlocks.insert( row, buf.data() );
+
+		snapshot->rows.append( buf.data() );
+	}
+
+	restoreState();
+
+	for ( int i = snapshots.count() - 1; i >= 0; i-- ) {
+		if ( snapshots.at( i ).expired() )
+			snapshots.removeAt( i );
+	}
+	snapshots.append( snapshot );
+
+	return snapshot;
+}
+
+bool NifModel::restoreSnapshot( const NifSnapshot & snapshot )
+{
+	int count = snapshot.types.count();
+	if ( snapshot.rows.count() != count + 2 )
+		return false;
+
+	QBuffer buf;
+	buf.setData( snapshot.rows.first() );
+	buf.open( QIODevice::ReadOnly );
+
+	// Deferred blocks are compared with the snapshot rather than decoded for the header change
+	setState( Loading );
+	NifIStream headerStream( this, &buf );
+	bool ok = loadHeader( getHeaderItem(), headerStream );
+	restoreState();
+	itemChanged( getHeaderItem() );
+
+	// The data kept for another format cannot be compared with the snapshot
+	checkBlockFormat();
+
+	auto removeBlock = [this]( int row ) {
+		beginRemoveRows( QModelIndex(), row, row );
+		NifItem * block = root->takeChild( row );
+		endRemoveRows();
+
+		cleanBlocks.remove( block );
+		rowSizes.remove( block );
+		delete block;
+	};
+
+	// Reads the items of a block from the snapshot into its existing rows
+	auto reloadBlock = [this]( NifItem * block, const QByteArray & data ) {
+		QBuffer blockBuf;
+		blockBuf.setData( data );
+		blockBuf.open( QIODevice::ReadOnly );
+
+		NifIStream stream( this, &blockBuf );
+		bool loaded = loadItem( block, stream ) && blockBuf.pos() == blockBuf.size();
+		itemChanged( block );
+		return loaded;
+	};
+
+	// Removing rows forgets the data of every block, so the blocks to keep are chosen beforehand
+	QVector<NifItem *> kept( count, nullptr );
+	for ( int b = 0; b < count && b < getBlockCount(); b++ ) {
+		NifItem * block = getBlockItem( b );
+		auto deferred = static_cast<NifBlockLoader *>( block->deferredLoader() );
+
+		QByteArray current = deferred ? deferred->data : cleanBlocks.value( block );
+		QString type = deferred ? deferred->rttiName : createRTTIName( block );
+		if ( type == snapshot.types.at( b ) && !current.isNull() && current == snapshot.rows.at( b + 1 ) )
+			kept[b] = block;
+	}
+
+	for ( int b = 0; b < count && ok; b++ ) {
+		const QString & rtti = snapshot.types.at( b );
+		const QByteArray & data = snapshot.rows.at( b + 1 );
+
+		if ( kept.at( b ) )
+			continue;
+
+		NiMesh::DataStreamMetadata metadata = {};
+		NifBlockPtr type = blocks.value( extractRTTIArgs( rtti, metadata ) );
+		if ( !type ) {
+			ok = false;
+			break;
+		}
+
+		if ( b < getBlockCount() ) {
+			// A block of the same type is restored in place, so that the indexes into it stay valid
+			NifItem * block = getBlockItem( b );
+			auto deferred = static_cast<NifBlockLoader *>( block->deferredLoader() );
+
+			if ( deferred && deferred->rttiName == rtti ) {
+				block->setLoader( new NifBlockLoader( this, rtti, data, metadata ) );
+				rowSizes.remove( block );
+				emit dataChanged( createIndex( block->row(), 0, block ), createIndex( block->row(), 0, block ) );
+				continue;
+			}
+
+			if ( !deferred && createRTTIName( block ) == rtti && reloadBlock( block, data ) ) {
+				kept[b] = block;
+				emit dataChanged( createIndex( block->row(), 0, block ), createIndex( block->row(), 0, block ) );
+				continue;
+			}
+
+			removeBlock( b + 1 );
+		}
+
+		// The block is decoded from the snapshot when its items are first accessed
+		beginInsertRows( QModelIndex(), b + 1, b + 1 );
+		NifItem * branch = insertBranch( root, type->data, b + 1 );
+		branch->setCondition( true );
+		branch->setLoader( new NifBlockLoader( this, rtti, data, metadata ) );
+		endInsertRows();
+	}
+
+	// Blocks which did not exist when the snapshot was taken
+	while ( ok && getBlockCount() > count )
+		removeBlock( count + 1 );
+
+	// The kept and reloaded blocks hold the data of the snapshot
+	for ( int b = 0; b < count && ok; b++ ) {
+		if ( kept.at( b ) && !kept.at( b )->isDeferred() )
+			cleanBlocks.insert( kept.at( b ), snapshot.rows.at( b + 1 ) );
+	}
+
+	buf.close();
+	buf.setData( snapshot.rows.last() );
+	buf.open( QIODevice::ReadOnly );
+
+	NifIStream footerStream( this, &buf );
+	ok = ok && loadItem( getFooterItem(), footerStream );
+
+	rowOffsets.clear();
+
+	updateLinks();
+	emit dataChanged( getHeader(), getHeader() );
+	emit dataChanged( getFooter(), getFooter() );
+	emit linksChanged();
+
+	return ok;
+}
+
 bool NifModel::loadIndex( QIODevice & device, const QModelIndex & index )
 {
 	NifItem * item = static_cast<NifItem *>( index.internalPointer() );
@@ -2089,6 +2850,7 @@ bool NifModel::loadIndex( QIODevice & device, const QModelIndex & index )
 	if ( item && index.isValid() && index.model() == this ) {
 		NifIStream stream( this, &device );
 		bool ok = loadItem( item, stream );
+		itemChanged( item );
 		updateLinks();
 		updateFooter();
 		emit linksChanged();
@@ -2106,6 +2868,7 @@ bool NifModel::loadAndMapLinks( QIODevice & device, const QModelIndex & index, c
 	if ( item && index.isValid() && index.model() == this ) {
 		NifIStream stream( this, &device );
 		bool ok = loadItem( item, stream );
+		itemChanged( item );
 		mapLinks( item, map );
 		updateLinks();
 		updateFooter();
@@ -2192,34 +2955,19 @@ int NifModel::fileOffset( const QModelIndex & index ) const
 	NifItem * target = static_cast<NifItem *>( index.internalPointer() );
 
 	if ( target && index.isValid() && index.model() == this ) {
-		int ofs = 0;
+		// Only the items of the block before the target are walked
+		NifItem * row = target;
+		while ( row->parent() && row->parent() != root )
+			row = row->parent();
 
-		for ( int c = 0; c < root->childCount(); c++ ) {
-			if ( c > 0 && c <= getBlockCount() ) {
-				if ( version > 0x0a000000 ) {
-					if ( version < 0x0a020000 ) {
-						ofs += 4;
-					}
-				} else {
-					if ( version < 0x0303000d ) {
-						if ( rootLinks.contains( c - 1 ) ) {
-							QString string = "Top Level Object";
-							ofs += 4 + string.length();
-						}
-					}
-
-					QString string = itemName( this->NifModel::index( c, 0 ) );
-					ofs += 4 + string.length();
+		if ( row->parent() != root )
+			return -1;
 
-					if ( version < 0x0303000d ) {
-						ofs += 4;
-					}
-				}
-			}
+		updateRowOffsets();
 
-			if ( fileOffset( root->child( c ), target, stream, ofs ) )
-				return ofs;
-		}
+		int ofs = int( rowOffsets.at( row->row() ) );
+		if ( fileOffset( row, target, stream, ofs ) )
+			return ofs;
 	}
 
 	return -1;
@@ -2267,7 +3015,10 @@ int NifModel::blockSize( NifItem * parent, NifSStream & stream ) const
 					}
 				}
 
-				size += blockSize( child, stream );
+				if ( auto packed = child->packedArray() )
+					size += packed->count * stream.size( packed->element.value );
+				else
+					size += blockSize( child, stream );
 			} else {
 				size += stream.size( child->value() );
 			}
@@ -2293,8 +3044,15 @@ bool NifModel::loadItem( NifItem * parent, NifIStream & stream )
 
 		if ( evalCondition( child ) ) {
 			if ( isArray( child ) ) {
-				if ( !updateArrayItem( child ) || !loadItem( child, stream ) )
+				if ( !updateArrayItem( child ) )
+					return false;
+
+				if ( auto packed = child->packedArray() ) {
+					if ( !stream.readPacked( packed->element.value, packed->data.data(), packed->count ) )
+						return false;
+				} else if ( !loadItem( child, stream ) ) {
 					return false;
+				}
 			} else if ( child->childCount() > 0 ) {
 				if ( !loadItem( child, stream ) )
 					return false;
@@ -2319,8 +3077,103 @@ bool NifModel::loadHeader( NifItem * header, NifIStream & stream )
 	set<int>( header, "User Version 2", 0 );
 
 	invalidateConditions( header, false );
-	
-	return loadItem( header, stream );
+
+	// The header fields evaluate their version conditions as they are read
+	headerConditionsValid = false;
+	if ( !loadItem( header, stream ) )
+		return false;
+
+	updateHeaderConditions();
+	return true;
+}
+
+void NifModel::updateHeaderConditions()
+{
+	NifModelEval functor( this, getHeaderItem() );
+
+	headerConditions.resize( versionConditions.count() );
+	for ( int i = 0; i < versionConditions.count(); i++ )
+		headerConditions.setBit( i, versionConditions.at( i ).evaluateBool( functor ) );
+
+	headerConditionsValid = true;
+
+	clearBlockTemplates();
+}
+
+void NifModel::insertBlockFields( NifItem * block, const NifBlockPtr & type )
+{
+	if ( NifItem * tmpl = blockTemplate( type ) ) {
+		block->cloneChildren( tmpl );
+		return;
+	}
+
+	if ( !type->ancestor.isEmpty() )
+		insertAncestor( block, type->ancestor );
+
+	block->prepareInsert( type->types.count() );
+
+	for ( const NifData & data : type->types ) {
+		insertType( block, data );
+	}
+}
+
+NifItem * NifModel::blockTemplate( const NifBlockPtr & type )
+{
+	// The version conditions of a template are only known for a complete header
+	if ( !headerConditionsValid )
+		return nullptr;
+
+	QMutexLocker locker( &templateLock );
+
+	if ( templateVersion != version ) {
+		if ( templateRoot )
+			templateRoot->killChildren();
+		blockTemplates.clear();
+		templateVersion = version;
+	}
+
+	NifItem * tmpl = blockTemplates.value( type->id );
+	if ( tmpl )
+		return tmpl;
+
+	if ( !templateRoot )
+		templateRoot.reset( new ( itemPool ) NifItem( nullptr ) );
+
+	// Blocks are inserted under the root, which keeps no link rows; the template root is the same
+	tmpl = templateRoot->insertChild( type->data );
+	tmpl->value().changeType( NifValue::tNone );
+	tmpl->setCondition( true );
+
+	if ( !type->ancestor.isEmpty() )
+		insertAncestor( tmpl, type->ancestor );
+
+	tmpl->prepareInsert( type->types.count() );
+
+	for ( const NifData & data : type->types ) {
+		insertType( tmpl, data );
+	}
+
+	// Evaluate the version conditions once, for every block cloned from the template
+	QStack<NifItem *> stack;
+	stack.push( tmpl );
+	while ( !stack.isEmpty() ) {
+		NifItem * item = stack.pop();
+		evalVersion( item, true );
+		for ( NifItem * c : item->children() )
+			stack.push( c );
+	}
+
+	blockTemplates.insert( type->id, tmpl );
+	return tmpl;
+}
+
+void NifModel::clearBlockTemplates()
+{
+	QMutexLocker locker( &templateLock );
+
+	if ( templateRoot )
+		templateRoot->killChildren();
+	blockTemplates.clear();
 }
 
 bool NifModel::saveItem( NifItem * parent, NifOStream & stream ) const
@@ -2346,8 +3199,16 @@ bool NifModel::saveItem( NifItem * parent, NifOStream & stream ) const
 					}
 				}
 
-				if ( !saveItem( child, stream ) )
+				if ( auto packed = child->packedArray() ) {
+					NifValue v( packed->element.value );
+					for ( int i = 0; i < packed->count; i++ ) {
+						v.fromPacked( packed->data.constData() + i * packed->size );
+						if ( !stream.write( v ) )
+							return false;
+					}
+				} else if ( !saveItem( child, stream ) ) {
 					return false;
+				}
 			} else {
 				if ( !stream.write( child->value() ) )
 					return false;
@@ -2368,7 +3229,9 @@ bool NifModel::fileOffset( NifItem * parent, NifItem * target, NifSStream & stre
 			return true;
 
 		if ( evalCondition( child ) ) {
-			if ( isArray( child ) || !child->arr2().isEmpty() || child->childCount() > 0 ) {
+			if ( auto packed = child->packedArray() ) {
+				ofs += packed->count * stream.size( packed->element.value );
+			} else if ( isArray( child ) || !child->arr2().isEmpty() || child->childCount() > 0 ) {
 				if ( fileOffset( child, target, stream, ofs ) )
 					return true;
 			} else {
@@ -2434,6 +3297,10 @@ bool NifModel::evalCondition( NifItem * item, bool chkParents ) const
 
 void NifModel::invalidateConditions( NifItem * item, bool refresh )
 {
+	// Elements of packed arrays are conditionless
+	if ( item->isPacked() )
+		return;
+
 	for ( NifItem * c : item->children() ) {
 		c->invalidateCondition();
 		c->invalidateVersionCondition();
@@ -2467,6 +3334,27 @@ void NifModel::invalidateDependentConditions( NifItem * item )
 	if ( !p || p == root )
 		return;
 
+	// Only the siblings whose expressions read the field, as linked by the row table of the parent
+	const auto & table = p->fieldRows();
+	if ( table && item->nameId().isValid() && p->childCount() == table->count ) {
+		for ( int r : table->dependents.value( item->nameId().value() ) ) {
+			NifItem * c = p->child( r );
+
+			c->invalidateCondition();
+			c->setCondition( BaseModel::evalCondition( c ) );
+		}
+
+		// Only an argument is passed on to the children; a length of an array is handled by updateArray
+		for ( int r : table->argDependents.value( item->nameId().value() ) ) {
+			NifItem * c = p->child( r );
+
+			if ( c->childCount() > 0 )
+				invalidateArgConditions( c );
+		}
+
+		return;
+	}
+
 	QString name = item->name();
 	for ( int i = item->row(); i < p->childCount(); i++ ) {
 		auto c = p->children().at( i );
@@ -2482,6 +3370,32 @@ void NifModel::invalidateDependentConditions( NifItem * item )
 	}
 }
 
+void NifModel::invalidateArgConditions( NifItem * item )
+{
+	// Elements of packed arrays are conditionless
+	if ( item->isPacked() )
+		return;
+
+	// The elements of arrays take their argument from the array
+	if ( isArray( item ) ) {
+		invalidateConditions( item, true );
+		return;
+	}
+
+	static const QLatin1String arg( "ARG" );
+
+	for ( NifItem * c : item->children() ) {
+		if ( c->cond().contains( arg ) ) {
+			c->invalidateCondition();
+			c->setCondition( BaseModel::evalCondition( c ) );
+		}
+
+		// The argument is passed on to the children of the child
+		if ( c->arg().contains( arg ) && c->childCount() > 0 )
+			invalidateArgConditions( c );
+	}
+}
+
 void NifModel::invalidateDependentConditions( const QModelIndex & index )
 {
 	auto item = static_cast<NifItem *>(index.internalPointer());
@@ -2506,6 +3420,7 @@ void NifModel::updateLinks( int block )
 		parentLinks[ block ].clear();
 		updateLinks( block, getBlockItem( block ) );
 	} else {
+		rootsPending = false;
 		rootLinks.clear();
 		childLinks.clear();
 		parentLinks.clear();
@@ -2596,7 +3511,7 @@ void NifModel::checkLinks( int block, QStack<int> & parents )
 
 void NifModel::adjustLinks( NifItem * parent, int block, int delta )
 {
-	if ( !parent )
+	if ( !parent || parent->isPacked() )
 		return;
 
 	if ( parent->childCount() > 0 ) {
@@ -2610,13 +3525,15 @@ void NifModel::adjustLinks( NifItem * parent, int block, int delta )
 				parent->value().setLink( -1 );
 			else
 				parent->value().setLink( l + delta );
+
+			itemChanged( parent );
 		}
 	}
 }
 
 void NifModel::mapLinks( NifItem * parent, const QMap<qint32, qint32> & map )
 {
-	if ( !parent )
+	if ( !parent || parent->isPacked() )
 		return;
 
 	if ( parent->childCount() > 0 ) {
@@ -2626,8 +3543,8 @@ void NifModel::mapLinks( NifItem * parent, const QMap<qint32, qint32> & map )
 		int l = parent->value().toLink();
 
 		if ( l >= 0 ) {
-			if ( map.contains( l ) )
-				parent->value().setLink( map[ l ] );
+			if ( map.contains( l ) && parent->value().setLink( map[ l ] ) )
+				itemChanged( parent );
 		}
 	}
 }
@@ -2657,6 +3574,21 @@ qint32 NifModel::getLink( const QModelIndex & parent, const QString & name ) con
 	return -1;
 }
 
+qint32 NifModel::getLink( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
+
+	if ( !( parent.isValid() && parentItem && parent.model() == this ) )
+		return -1;
+
+	NifItem * item = getItem( parentItem, field );
+
+	if ( item )
+		return item->value().toLink();
+
+	return -1;
+}
+
 QVector<qint32> NifModel::getLinkArray( const QModelIndex & iArray ) const
 {
 	QVector<qint32> links;
@@ -2681,6 +3613,11 @@ QVector<qint32> NifModel::getLinkArray( const QModelIndex & parent, const QStrin
 	return getLinkArray( getIndex( parent, name ) );
 }
 
+QVector<qint32> NifModel::getLinkArray( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	return getLinkArray( getIndex( parent, field ) );
+}
+
 bool NifModel::setLink( const QModelIndex & parent, const QString & name, qint32 l )
 {
 	NifItem * parentItem = static_cast<NifItem *>( parent.internalPointer() );
@@ -2691,6 +3628,7 @@ bool NifModel::setLink( const QModelIndex & parent, const QString & name, qint32
 	NifItem * item = getItem( parentItem, name );
 
 	if ( item && item->value().setLink( l ) ) {
+		itemChanged( item );
 		emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
 		NifItem * parent = item;
 
@@ -2717,6 +3655,7 @@ bool NifModel::setLink( const QModelIndex & index, qint32 l )
 		return false;
 
 	if ( item && item->value().setLink( l ) ) {
+		itemChanged( item );
 		emit dataChanged( createIndex( item->row(), ValueCol, item ), createIndex( item->row(), ValueCol, item ) );
 		NifItem * parent = item;
 
@@ -2746,6 +3685,8 @@ bool NifModel::setLinkArray( const QModelIndex & iArray, const QVector<qint32> &
 			ret &= item->child( c )->value().setLink( links[c] );
 		}
 
+		itemChanged( item );
+
 		ret &= item->childCount() == links.count();
 		int x = item->childCount() - 1;
 
@@ -2784,12 +3725,24 @@ bool NifModel::isLink( const QModelIndex & index, bool * isChildLink ) const
 	return itemIsLink( item, isChildLink );
 }
 
+QList<int> NifModel::getRootLinks() const
+{
+	// Any block that no other block links to is a root, which is only known once every block is decoded
+	if ( rootsPending ) {
+		NifModel * mdl = const_cast<NifModel *>( this );
+		mdl->loadDeferredBlocks( 1 );
+		mdl->updateLinks();
+	}
+
+	return rootLinks;
+}
+
 int NifModel::getParent( int block ) const
 {
 	int parent = -1;
 
 	for ( int b = 0; b < getBlockCount(); b++ ) {
-		if ( childLinks.value( b ).contains( block ) ) {
+		if ( getChildLinks( b ).contains( block ) ) {
 			parent = b;
 			break;
 		}
@@ -2965,6 +3918,7 @@ void NifModel::convertNiBlock( const QString & identifier, const QModelIndex & i
 
 	if ( srcBlock && dstBlock && branch ) {
 		branch->setName( identifier );
+		branch->setFieldRows( dstBlock->fieldRows );
 
 		if ( inherits( btype, identifier ) ) {
 			// Remove any level between the two types
@@ -3087,3 +4041,22 @@ QVariant NifModelEval::operator()( const QVariant & v ) const
 
 	return v;
 }
+
+quint32 NifModelEval::operator()( const NifExpr::Symbol & sym ) const
+{
+	NifItem * i = const_cast<NifItem *>(item);
+
+	if ( sym.field.isValid() )
+		i = model->getItem( i, sym.field );
+	else
+		i = model->getItem( i, sym.name );
+
+	if ( i ) {
+		if ( i->value().isCount() )
+			return i->value().toCount();
+		else if ( i->value().isFileVersion() )
+			return i->value().toFileVersion();
+	}
+
+	return 0;
+}
@@ -35,8 +35,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "basemodel.h" // Inherited
 
+#include <QBitArray>
 #include <QHash>
 #include <QReadWriteLock>
+#include <QSet>
 #include <QStack>
 #include <QStringList>
 
@@ -49,7 +51,7 @@ class QUndoStack;
 using NifBlockPtr = std::shared_ptr<NifBlock>;
 using SpellBookPtr = std::shared_ptr<SpellBook>;
 
-//! @file nifmodel.h NifModel, NifModelEval
+//! @file nifmodel.h NifModel, NifModelEval, NifBlockLoader, NifSnapshot
 
 
 //! Primary string for read failure
@@ -59,6 +61,20 @@ const char * const readFail = QT_TR_NOOP( "The NIF file could not be read. See D
 const char * const readFailFinal = QT_TR_NOOP( "Failed to load %1" );
 
 
+/*! The encoded header, blocks and footer of a NifModel at some point, see NifModel::takeSnapshot().
+ *
+ * The data of blocks which were not changed since they were last read or written is shared
+ * with the model, so a snapshot only costs the size of the blocks changed since then.
+ */
+struct NifSnapshot
+{
+	//! The block types as stored in the header, see NifModel::createRTTIName()
+	QStringList types;
+	//! The data of the header, the blocks and the footer
+	QVector<QByteArray> rows;
+};
+
+
 //! The main data model for the NIF file.
 class NifModel final : public BaseModel
 {
@@ -68,6 +84,8 @@ class NifModel final : public BaseModel
 	friend class NifModelEval;
 	friend class NifOStream;
 	friend class ArrayUpdateCommand;
+	friend class NifBlockLoader;
+	friend class Benchmark;
 
 public:
 	NifModel( QObject * parent = 0 );
@@ -103,6 +121,9 @@ public:
 	template <typename T> T get( const QModelIndex & parent, const QString & name ) const;
 	template <typename T> bool set( const QModelIndex & parent, const QString & name, const T & v );
 
+	template <typename T> T get( const QModelIndex & parent, const NifFieldId & field ) const;
+	template <typename T> bool set( const QModelIndex & parent, const NifFieldId & field, const T & v );
+
 	// end BaseModel
 
 	//! Load from QIODevice and index
@@ -120,6 +141,8 @@ public:
 	//! Invalidate only the conditions of the items dependent on this item
 	void invalidateDependentConditions( NifItem * item );
 	void invalidateDependentConditions( const QModelIndex & index );
+	//! Invalidate the conditions under an item which read its argument
+	void invalidateArgConditions( NifItem * item );
 
 	//! Loads a model and maps links
 	bool loadAndMapLinks( QIODevice & device, const QModelIndex &, const QMap<qint32, qint32> & map );
@@ -250,8 +273,11 @@ public:
 	 * @param name		The name of the link
 	 */
 	int getLink( const QModelIndex & parent, const QString & name ) const;
+	//! Get the block number of a link, by the interned name of the link
+	int getLink( const QModelIndex & parent, const NifFieldId & field ) const;
 	QVector<qint32> getLinkArray( const QModelIndex & array ) const;
 	QVector<qint32> getLinkArray( const QModelIndex & parent, const QString & name ) const;
+	QVector<qint32> getLinkArray( const QModelIndex & parent, const NifFieldId & field ) const;
 	bool setLink( const QModelIndex & index, qint32 l );
 	bool setLink( const QModelIndex & parent, const QString & name, qint32 l );
 	bool setLinkArray( const QModelIndex & array, const QVector<qint32> & links );
@@ -298,6 +324,15 @@ public:
 	//! Undo Stack for changes to NifModel
 	QUndoStack * undoStack = nullptr;
 
+	//! Encode the header, blocks and footer as they are now; null if a block could not be encoded
+	std::shared_ptr<NifSnapshot> takeSnapshot();
+	/*! Restore the header, blocks and footer of a snapshot
+	 *
+	 * Blocks whose data is the same as in the snapshot are kept. The others are replaced,
+	 * and decoded from the snapshot when their items are first accessed.
+	 */
+	bool restoreSnapshot( const NifSnapshot & snapshot );
+
 public slots:
 	void updateSettings();
 
@@ -310,11 +345,17 @@ protected:
 	// BaseModel
 
 	NifItem * getItem( NifItem * parent, const QString & name ) const override final;
+	NifItem * getItem( NifItem * parent, const NifFieldId & field ) const override final;
 
 	bool setItemValue( NifItem * item, const NifValue & v ) override final;
 
 	bool updateArrayItem( NifItem * array ) override final;
 
+	void itemChanging( NifItem * item ) override final;
+	void itemChanged( NifItem * item ) override final;
+
+	void releaseMapping() override final;
+
 	QString ver2str( quint32 v ) const override final { return version2string( v ); }
 	quint32 str2ver( QString s ) const override final { return version2number( s ); }
 
@@ -326,12 +367,23 @@ protected:
 	template <typename T> T get( NifItem * item ) const;
 	template <typename T> bool set( NifItem * parent, const QString & name, const T & d );
 	template <typename T> bool set( NifItem * item, const T & d );
+	template <typename T> T get( NifItem * parent, const NifFieldId & field ) const;
+	template <typename T> bool set( NifItem * parent, const NifFieldId & field, const T & d );
 
 	// end BaseModel
 
 	bool loadItem( NifItem * parent, NifIStream & stream );
 	bool loadHeader( NifItem * parent, NifIStream & stream );
+	void loadDeferredBlock( NifItem * block, const NifBlockLoader & loader );
+	void loadDeferredBlocks( int threads );
 	bool saveItem( NifItem * parent, NifOStream & stream ) const;
+	bool saveBlock( NifItem * block, QIODevice & device ) const;
+	qint64 fileSize() const;
+	int rowSize( NifItem * item ) const;
+	int rowPrefixSize( int row ) const;
+	void updateRowOffsets() const;
+	void checkBlockFormat() const;
+	void keepBlockData( NifItem * block, QIODevice & device, qint64 pos );
 	bool fileOffset( NifItem * parent, NifItem * target, NifSStream & stream, int & ofs ) const;
 
 	NifItem * getHeaderItem() const;
@@ -363,6 +415,18 @@ protected:
 	QHash<int, QList<int> > childLinks;
 	QHash<int, QList<int> > parentLinks;
 	QList<int> rootLinks;
+	//! The root links were taken from the footer, as blocks were left undecoded on load
+	bool rootsPending = false;
+
+	//! The file data of blocks which were not changed since they were last loaded or saved
+	mutable QHash<const NifItem *, QByteArray> cleanBlocks;
+	//! The version, user version and user version 2 the clean blocks were encoded for
+	mutable QVector<quint32> cleanFormat;
+	//! The sizes of the header, the blocks and the footer which were not changed since they were last measured
+	mutable QHash<const NifItem *, int> rowSizes;
+	//! The file offsets of the rows of the root, rebuilt from their sizes after any change
+	mutable QVector<qint64> rowOffsets;
+	QVector<quint32> blockFormat() const { return { version, getUserVersion(), getUserVersion2() }; }
 
 	bool lockUpdates;
 
@@ -380,6 +444,20 @@ protected:
 
 	//! Parse the XML file using a NifXmlHandler
 	static QString parseXmlDescription( const QString & filename );
+	//! Read the XML structures from a SchemaCache
+	static bool readSchema( QDataStream & ds );
+	//! Write the XML structures to a SchemaCache
+	static void writeSchema( QDataStream & ds );
+
+	//! Log the number of items and the bytes per item to the nifskope.nif category, if its debug output is enabled
+	void reportMemoryUsage() const;
+
+	//! Get the data of the rows of an array, shared by the rows of all arrays of the same field
+	static NifData arrayRowData( const NifData & array, bool binary );
+	//! Get a templated field with its template filled, shared by all fields of the same field and template
+	static NifData templateData( const NifData & data, const QString & tmp );
+	//! Clear the data shared by arrayRowData() and templateData()
+	static void clearDerivedData();
 
 	// XML structures
 	static QList<quint32> supportedVersions;
@@ -387,6 +465,36 @@ protected:
 	static QHash<QString, NifBlockPtr> fixedCompounds;
 	static QHash<QString, NifBlockPtr> blocks;
 	static QMap<quint32, NifBlockPtr> blockHashes;
+	//! The distinct version conditions of the XML, numbered by NifData::vercondId()
+	static QVector<NifExpr> versionConditions;
+	//! The fields read by the version conditions
+	static QSet<int> versionConditionFields;
+
+	//! Evaluate all version conditions against the header
+	void updateHeaderConditions();
+	//! The results of the version conditions for the header, by number
+	QBitArray headerConditions;
+	//! Whether headerConditions is up to date; not while the header is being loaded
+	bool headerConditionsValid = false;
+
+	//! Insert the fields of a block type into a block item, cloned from the template of the type
+	void insertBlockFields( NifItem * block, const NifBlockPtr & type );
+	//! Get the template of a block type, with its fields inserted and their version conditions evaluated
+	NifItem * blockTemplate( const NifBlockPtr & type );
+	//! Discard the block templates, whenever the header they were evaluated against changes
+	void clearBlockTemplates();
+
+	//! The parent of the block templates, which is not part of the model
+	std::unique_ptr<NifItem> templateRoot;
+	//! The block templates by block type
+	QHash<QString, NifItem *> blockTemplates;
+	//! The version the block templates were made for
+	quint32 templateVersion = 0;
+	//! Guards the block templates, which are made by the threads that decode blocks
+	QMutex templateLock;
+
+	//! The snapshots taken of the model, whose data is copied when the file mapping is released
+	QVector<std::weak_ptr<NifSnapshot>> snapshots;
 
 private:
 	struct Settings
@@ -398,6 +506,30 @@ private:
 };
 
 
+/*! The file data of a block whose decoding is deferred until its items are accessed.
+ *
+ * Used by NifModel::load() when block sizes are known from the header.
+ */
+class NifBlockLoader final : public NifItemLoader
+{
+public:
+	NifBlockLoader( NifModel * m, const QString & rtti, const QByteArray & d, const NiMesh::DataStreamMetadata & md )
+		: model( m ), rttiName( rtti ), data( d ), metadata( md ) {}
+
+	void load( NifItem * block ) override final;
+	void detach() override final { data.detach(); }
+
+	//! The model the block belongs to
+	NifModel * model;
+	//! The block type as stored in the header, see NifModel::createRTTIName()
+	QString rttiName;
+	//! The data of the block in the file
+	QByteArray data;
+	//! The arguments of an NiDataStream block type
+	NiMesh::DataStreamMetadata metadata;
+};
+
+
 //! Helper class for evaluating condition expressions
 class NifModelEval
 {
@@ -405,6 +537,7 @@ public:
 	NifModelEval( const NifModel * model, const NifItem * item );
 
 	QVariant operator()( const QVariant & v ) const;
+	quint32 operator()( const NifExpr::Symbol & sym ) const;
 private:
 	const NifModel * model;
 	const NifItem * item;
@@ -456,18 +589,20 @@ inline bool NifModel::isVersionSupported( quint32 v )
 	return supportedVersions.contains( v );
 }
 
-inline QList<int> NifModel::getRootLinks() const
-{
-	return rootLinks;
-}
-
 inline QList<int> NifModel::getChildLinks( int block ) const
 {
+	// Links of a deferred block are collected when it is decoded
+	if ( NifItem * item = getBlockItem( block ) )
+		item->materialize();
+
 	return childLinks.value( block );
 }
 
 inline QList<int> NifModel::getParentLinks( int block ) const
 {
+	if ( NifItem * item = getBlockItem( block ) )
+		item->materialize();
+
 	return parentLinks.value( block );
 }
 
@@ -508,6 +643,16 @@ template <typename T> inline T NifModel::get( const QModelIndex & parent, const
 	return BaseModel::get<T>( parent, name );
 }
 
+template <typename T> inline T NifModel::get( NifItem * parent, const NifFieldId & field ) const
+{
+	return BaseModel::get<T>( parent, field );
+}
+
+template <typename T> inline T NifModel::get( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	return BaseModel::get<T>( parent, field );
+}
+
 template <typename T> inline bool NifModel::set( const QModelIndex & index, const T & d )
 {
 	bool result = BaseModel::set<T>( index, d );
@@ -540,6 +685,22 @@ template <typename T> inline bool NifModel::set( NifItem * parent, const QString
 	return result;
 }
 
+template <typename T> inline bool NifModel::set( const QModelIndex & parent, const NifFieldId & field, const T & d )
+{
+	bool result = BaseModel::set<T>( parent, field, d );
+	if ( result )
+		invalidateDependentConditions( getIndex( parent, field ) );
+	return result;
+}
+
+template <typename T> inline bool NifModel::set( NifItem * parent, const NifFieldId & field, const T & d )
+{
+	bool result = BaseModel::set<T>( parent, field, d );
+	if ( result )
+		invalidateDependentConditions( getItem( parent, field ) );
+	return result;
+}
+
 template <> inline QString NifModel::get( const QModelIndex & index ) const
 {
 	return this->string( index );
@@ -558,6 +719,11 @@ template <> inline QString NifModel::get( const QModelIndex & parent, const QStr
 	return this->string( parent, name );
 }
 
+template <> inline QString NifModel::get( const QModelIndex & parent, const NifFieldId & field ) const
+{
+	return this->string( getIndex( parent, field ) );
+}
+
 template <> inline bool NifModel::set( const QModelIndex & index, const QString & d )
 {
 	return this->assignString( index, d );
@@ -572,6 +738,11 @@ template <> inline bool NifModel::set( const QModelIndex & parent, const QString
 	return this->assignString( parent, name, d );
 }
 
+template <> inline bool NifModel::set( const QModelIndex & parent, const NifFieldId & field, const QString & d )
+{
+	return this->assignString( getIndex( parent, field ), d );
+}
+
 //template <> inline bool NifModel::set( NifItem * parent, const QString & name, const QString & d ) {
 //	return this->assignString(parent, name, d);
 //}
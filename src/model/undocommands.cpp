@@ -36,9 +36,45 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "model/nifmodel.h"
 
 #include <QCoreApplication>
+#include <QMultiHash>
+#include <QTimer>
+#include <QUndoStack>
 
 
-//! @file undocommands.cpp ChangeValueCommand, ToggleCheckBoxListCommand
+//! @file undocommands.cpp IndexCommand, ChangeValueCommand, ToggleCheckBoxListCommand, SpellCommand
+
+/*
+ *  IndexCommand
+ */
+
+//! The commands holding indexes into each model
+static QMultiHash<const NifModel *, const IndexCommand *> & indexCommands()
+{
+	static QMultiHash<const NifModel *, const IndexCommand *> commands;
+	return commands;
+}
+
+IndexCommand::IndexCommand( NifModel * model )
+	: QUndoCommand(), nif( model )
+{
+	indexCommands().insert( nif, this );
+}
+
+IndexCommand::~IndexCommand()
+{
+	indexCommands().remove( nif, this );
+}
+
+bool IndexCommand::hasStale( const NifModel * model )
+{
+	for ( auto it = indexCommands().constFind( model ); it != indexCommands().constEnd() && it.key() == model; ++it ) {
+		if ( it.value()->isStale() )
+			return true;
+	}
+
+	return false;
+}
+
 
 size_t ChangeValueCommand::lastID = 0;
 
@@ -48,7 +84,7 @@ size_t ChangeValueCommand::lastID = 0;
 
 ChangeValueCommand::ChangeValueCommand( const QModelIndex & index,
 	const QVariant & value, const QString & valueString, const QString & valueType, NifModel * model )
-	: QUndoCommand(), nif( model )
+	: IndexCommand( model )
 {
 	idxs << index;
 	oldValues << index.data( Qt::EditRole );
@@ -67,7 +103,7 @@ ChangeValueCommand::ChangeValueCommand( const QModelIndex & index,
 
 ChangeValueCommand::ChangeValueCommand( const QModelIndex & index, const NifValue & oldVal, 
 										const NifValue & newVal, const QString & valueType, NifModel * model )
-	: QUndoCommand(), nif( model )
+	: IndexCommand( model )
 {
 	idxs << index;
 	oldValues << oldVal.toVariant();
@@ -151,6 +187,16 @@ void ChangeValueCommand::createTransaction()
 	lastID++;
 }
 
+bool ChangeValueCommand::isStale() const
+{
+	for ( const auto & idx : idxs ) {
+		if ( !idx.isValid() )
+			return true;
+	}
+
+	return false;
+}
+
 
 /*
  *  ToggleCheckBoxListCommand
@@ -158,7 +204,7 @@ void ChangeValueCommand::createTransaction()
 
 ToggleCheckBoxListCommand::ToggleCheckBoxListCommand( const QModelIndex & index,
 	const QVariant & value, const QString & valueType, NifModel * model )
-	: QUndoCommand(), nif( model ), idx( index )
+	: IndexCommand( model ), idx( index )
 {
 	oldValue = index.data( Qt::EditRole );
 	newValue = value;
@@ -187,7 +233,7 @@ void ToggleCheckBoxListCommand::undo()
 }
 
 ArrayUpdateCommand::ArrayUpdateCommand( const QModelIndex & index, NifModel * model )
-	: QUndoCommand(), nif( model ), idx( index )
+	: IndexCommand( model ), idx( index )
 {
 	setText( QCoreApplication::translate( "ArrayUpdateCommand", "Update Array" ) );
 }
@@ -208,3 +254,41 @@ void ArrayUpdateCommand::undo()
 		nif->updateArray( idx );
 	}
 }
+
+
+/*
+ *  SpellCommand
+ */
+
+SpellCommand::SpellCommand( const QString & spellName, const std::shared_ptr<NifSnapshot> & before,
+							const std::shared_ptr<NifSnapshot> & after, NifModel * model )
+	: QUndoCommand(), nif( model ), before( before ), after( after )
+{
+	setText( QCoreApplication::translate( "SpellCommand", "Cast %1" ).arg( spellName ) );
+}
+
+void SpellCommand::redo()
+{
+	// QUndoStack::push() redoes the command, but the spell has just been cast
+	if ( cast ) {
+		cast = false;
+		return;
+	}
+
+	restore( *after );
+}
+
+void SpellCommand::undo()
+{
+	restore( *before );
+}
+
+void SpellCommand::restore( const NifSnapshot & snapshot )
+{
+	nif->restoreSnapshot( snapshot );
+
+	// Blocks whose type changed are replaced, which leaves the indexes of other commands pointing nowhere.
+	//	The stack cannot be cleared while it is undoing or redoing, so this is done once it returns.
+	if ( nif->undoStack && IndexCommand::hasStale( nif ) )
+		QTimer::singleShot( 0, nif->undoStack, &QUndoStack::clear );
+}
@@ -37,13 +37,33 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QModelIndex>
 #include <QVariant>
 
+#include <memory>
 
-//! @file undocommands.h ChangeValueCommand, ToggleCheckBoxListCommand
+
+//! @file undocommands.h IndexCommand, ChangeValueCommand, ToggleCheckBoxListCommand, SpellCommand
 
 class NifModel;
 class NifValue;
+struct NifSnapshot;
+
+//! An undo command that refers to the items of a model through persistent indexes
+class IndexCommand : public QUndoCommand
+{
+public:
+	IndexCommand( NifModel * model );
+	~IndexCommand();
+
+	//! Whether an index of the command no longer refers to an item
+	virtual bool isStale() const = 0;
+
+	//! Whether any command on the model can no longer be applied
+	static bool hasStale( const NifModel * model );
 
-class ChangeValueCommand : public QUndoCommand
+protected:
+	NifModel * nif;
+};
+
+class ChangeValueCommand : public IndexCommand
 {
 public:
 	ChangeValueCommand( const QModelIndex & index, const QVariant & value,
@@ -62,8 +82,9 @@ public:
 	//! Increments the lastID
 	static void createTransaction();
 
+	bool isStale() const override;
+
 private:
-	NifModel * nif;
 	QVector<QVariant> newValues, oldValues;
 	QVector<QPersistentModelIndex> idxs;
 
@@ -75,29 +96,48 @@ private:
 };
 
 
-class ToggleCheckBoxListCommand : public QUndoCommand
+class ToggleCheckBoxListCommand : public IndexCommand
 {
 public:
 	ToggleCheckBoxListCommand( const QModelIndex & index, const QVariant & value, const QString & valueType, NifModel * model );
 	void redo() override;
 	void undo() override;
+	bool isStale() const override { return !idx.isValid(); }
 private:
-	NifModel * nif;
 	QVariant newValue, oldValue;
 	QPersistentModelIndex idx;
 };
 
 
-class ArrayUpdateCommand : public QUndoCommand
+class ArrayUpdateCommand : public IndexCommand
 {
 public:
 	ArrayUpdateCommand( const QModelIndex & index, NifModel * model );
 	void redo() override;
 	void undo() override;
+	bool isStale() const override { return !idx.isValid(); }
 private:
-	NifModel * nif;
 	uint newSize, oldSize;
 	QPersistentModelIndex idx;
 };
 
+
+//! Undoes a spell by restoring the blocks from snapshots taken before and after it was cast
+class SpellCommand : public QUndoCommand
+{
+public:
+	SpellCommand( const QString & spellName, const std::shared_ptr<NifSnapshot> & before,
+				  const std::shared_ptr<NifSnapshot> & after, NifModel * model );
+	void redo() override;
+	void undo() override;
+private:
+	//! Restores a snapshot and drops the undo history if other commands no longer apply
+	void restore( const NifSnapshot & snapshot );
+
+	NifModel * nif;
+	std::shared_ptr<NifSnapshot> before, after;
+	//! The spell was already cast when the command was pushed
+	bool cast = true;
+};
+
 #endif // UNDOCOMMANDS_H
@@ -32,6 +32,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "spellbook.h"
 
+#include "model/undocommands.h"
 #include "ui/checkablemessagebox.h"
 
 #include <QCache>
@@ -110,7 +111,14 @@ void SpellBook::cast( NifModel * nif, const QModelIndex & index, SpellPtr spell
 
 	QDialogButtonBox::StandardButton response = QDialogButtonBox::Yes;
 
-	if ( !suppressConfirm && spell->page() != "Array" ) {
+	// The blocks as they are before the spell, so that it can be undone, unless there is nothing to undo
+	//	or the spell pushes its own commands
+	bool noSnapshot = spell && ( spell->constant() || spell->undoable() );
+	std::shared_ptr<NifSnapshot> before;
+	if ( nif && nif->undoStack && spell && !noSnapshot && spell->isApplicable( nif, index ) )
+		before = nif->takeSnapshot();
+
+	if ( !before && !noSnapshot && !suppressConfirm && spell->page() != "Array" ) {
 		response = CheckableMessageBox::question( this, "Confirmation", "This action cannot currently be undone. Do you want to continue?", "Do not ask me again", &accepted );
 
 		if ( accepted )
@@ -134,6 +142,12 @@ void SpellBook::cast( NifModel * nif, const QModelIndex & index, SpellPtr spell
 			emit nif->dataChanged( idx, idx );
 		}
 
+		if ( before ) {
+			auto after = nif->takeSnapshot();
+			if ( after && ( after->types != before->types || after->rows != before->rows ) )
+				nif->undoStack->push( new SpellCommand( spell->name(), before, after, nif ) );
+		}
+
 		emit sigIndex( idx );
 	}
 }
@@ -77,6 +77,10 @@ public:
 	virtual bool instant() const { return false; }
 	//! Whether the spell performs a sanitizing function
 	virtual bool sanity() const { return false; }
+	//! Whether the spell leaves the model unchanged, so that there is nothing to undo
+	virtual bool constant() const { return false; }
+	//! Whether the spell pushes its own commands onto the undo stack
+	virtual bool undoable() const { return false; }
 	//! Whether the spell has a high processing cost
 	virtual bool batch() const { return (page() == "Batch") || (page() == "Block") || (page() == "Mesh"); }
 	//! Hotkey sequence
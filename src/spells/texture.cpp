@@ -524,6 +524,7 @@ class spTextureTemplate final : public Spell
 {
 	QString name() const override final { return Spell::tr( "Export Template" ); }
 	QString page() const override final { return Spell::tr( "Texture" ); }
+	bool constant() const override final { return true; }
 
 	bool isApplicable( const NifModel * nif, const QModelIndex & index ) override final
 	{
@@ -591,12 +591,7 @@ void SettingsResources::write()
 	settings.setValue( "Settings/Resources/Archives", archives->stringList() );
 
 	// Sync FSManager to Archives list
-	archiveMgr->archives.clear();
-	for ( const QString an : archives->stringList() ) {
-		if ( !archiveMgr->archives.contains( an ) )
-			if ( auto a = FSArchiveHandler::openArchive( an ) )
-				archiveMgr->archives.insert( an, a );
-	}
+	archiveMgr->registerArchives( archives->stringList() );
 
 	settings.setValue( "Settings/Resources/Alternate Extensions", ui->chkAlternateExt->isChecked() );
 
@@ -32,8 +32,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "message.h"
 #include "model/kfmmodel.h"
+#include "xml/schemacache.h"
 
 #include <QtXml> // QXmlDefaultHandler Inherited
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QMessageBox>
 
@@ -299,18 +301,57 @@ QString KfmModel::parseXmlDescription( const QString & filename )
 	if ( !f.open( QIODevice::ReadOnly | QIODevice::Text ) )
 		return tr( "Couldn't open KFM XML description file: %1" ).arg( filename );
 
+	QByteArray xml = f.readAll();
+
+	// Skip parsing when the tables of this XML were cached before
+	SchemaCache cache( QFileInfo( filename ).fileName(), xml );
+	if ( QDataStream * ds = cache.read() ) {
+		if ( readSchema( *ds ) )
+			return QString();
+
+		compounds.clear();
+		supportedVersions.clear();
+	}
+
+	QBuffer buf( &xml );
+	buf.open( QIODevice::ReadOnly );
+
 	KfmXmlHandler handler;
 	QXmlSimpleReader reader;
 	reader.setContentHandler( &handler );
 	reader.setErrorHandler( &handler );
-	QXmlInputSource source( &f );
+	QXmlInputSource source( &buf );
 	reader.parse( source );
 
 	if ( !handler.errorString().isEmpty() ) {
 		compounds.clear();
 		supportedVersions.clear();
+	} else {
+		writeSchema( *cache.write() );
+		cache.commit();
 	}
 
 	return handler.errorString();
 }
 
+bool KfmModel::readSchema( QDataStream & ds )
+{
+	quint32 count;
+
+	ds >> supportedVersions >> count;
+	for ( quint32 i = 0; i < count && ds.status() == QDataStream::Ok; i++ ) {
+		NifBlockPtr c( new NifBlock );
+		ds >> *c;
+		compounds.insert( c->id, c );
+	}
+
+	return ds.status() == QDataStream::Ok && ds.atEnd();
+}
+
+void KfmModel::writeSchema( QDataStream & ds )
+{
+	ds << supportedVersions << quint32( compounds.count() );
+	for ( NifBlockPtr c : compounds )
+		ds << *c;
+}
+
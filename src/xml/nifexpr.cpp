@@ -162,7 +162,7 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	QRegularExpressionMatch reUnaryMatch = reUnary.match( cond, offset );
 	pos = reUnaryMatch.capturedStart();
 	if ( pos != -1 ) {
-		NifExpr e( reUnaryMatch.captured( 1 ).trimmed() );
+		NifExpr e( reUnaryMatch.captured( 1 ).trimmed(), Nested() );
 		opcode = NifExpr::e_not;
 		rhs = QVariant::fromValue( e );
 		return;
@@ -231,8 +231,8 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	rstartpos = oendpos + 1;
 	rendpos = cond.size() - 1;
 
-	NifExpr lhsexp( cond.mid( lstartpos, lendpos - lstartpos + 1 ).trimmed() );
-	NifExpr rhsexp( cond.mid( rstartpos, rendpos - rstartpos + 1 ).trimmed() );
+	NifExpr lhsexp( cond.mid( lstartpos, lendpos - lstartpos + 1 ).trimmed(), Nested() );
+	NifExpr rhsexp( cond.mid( rstartpos, rendpos - rstartpos + 1 ).trimmed(), Nested() );
 
 	if ( lhsexp.opcode == NifExpr::e_nop ) {
 		lhs = lhsexp.lhs;
@@ -249,6 +249,214 @@ void NifExpr::partition( const QString & cond, int offset /*= 0*/ )
 	}
 }
 
+void NifExpr::compile()
+{
+	program.clear();
+	symbols.clear();
+
+	int depth = 0, maxDepth = 0;
+	if ( !compileExpr( *this, depth, maxDepth ) || depth != 1 || maxDepth > MaxStack ) {
+		// Leave the expression to the QVariant evaluator
+		program.clear();
+		symbols.clear();
+	}
+
+	program.squeeze();
+	symbols.squeeze();
+}
+
+bool NifExpr::compileExpr( const NifExpr & e, int & depth, int & maxDepth )
+{
+	switch ( e.opcode ) {
+	case NifExpr::e_nop:
+		return compileValue( e.lhs, depth, maxDepth );
+	case NifExpr::e_not:
+		if ( !compileValue( e.rhs, depth, maxDepth ) )
+			return false;
+
+		program.append( { NifExpr::e_not, 0 } );
+		return true;
+	case NifExpr::e_const:
+	case NifExpr::e_symbol:
+		return false;
+	default:
+		break;
+	}
+
+	if ( !compileValue( e.lhs, depth, maxDepth ) || !compileValue( e.rhs, depth, maxDepth ) )
+		return false;
+
+	program.append( { e.opcode, 0 } );
+	--depth;
+	return true;
+}
+
+bool NifExpr::compileValue( const QVariant & v, int & depth, int & maxDepth )
+{
+	switch ( v.type() ) {
+	case QVariant::Int:
+	case QVariant::UInt:
+		program.append( { NifExpr::e_const, v.toUInt() } );
+		break;
+	case QVariant::String:
+		{
+			QString name = v.toString();
+
+			int idx = 0;
+			for ( ; idx < symbols.count(); idx++ ) {
+				if ( symbols.at( idx ).name == name )
+					break;
+			}
+
+			if ( idx == symbols.count() ) {
+				Symbol sym;
+				sym.name = name;
+				sym.isArg = ( name == "ARG" );
+
+				if ( !sym.isArg && !name.contains( QLatin1String( "\\" ) ) )
+					sym.field = NifFieldId( name );
+
+				symbols.append( sym );
+			}
+
+			program.append( { NifExpr::e_symbol, quint32( idx ) } );
+		}
+		break;
+	case QVariant::UserType:
+		if ( v.canConvert<NifExpr>() )
+			return compileExpr( v.value<NifExpr>(), depth, maxDepth );
+
+		return false;
+	default:
+		// Invalid operands keep the QVariant semantics
+		return false;
+	}
+
+	maxDepth = qMax( maxDepth, ++depth );
+	return true;
+}
+
+//! Kinds of operands written by NifExpr::writeOperand()
+enum OperandTag
+{
+	operandNone, operandString, operandInt, operandUInt, operandExpr
+};
+
+void NifExpr::writeTree( QDataStream & ds ) const
+{
+	ds << quint8( opcode );
+	writeOperand( ds, lhs );
+	writeOperand( ds, rhs );
+}
+
+void NifExpr::readTree( QDataStream & ds )
+{
+	quint8 op;
+	ds >> op;
+	opcode = Operator( op );
+	readOperand( ds, lhs );
+	readOperand( ds, rhs );
+}
+
+void NifExpr::writeOperand( QDataStream & ds, const QVariant & v )
+{
+	switch ( v.type() ) {
+	case QVariant::Invalid:
+		ds << quint8( operandNone );
+		break;
+	case QVariant::Int:
+		ds << quint8( operandInt ) << v.toInt();
+		break;
+	case QVariant::UInt:
+		ds << quint8( operandUInt ) << v.toUInt();
+		break;
+	case QVariant::UserType:
+		if ( v.canConvert<NifExpr>() ) {
+			ds << quint8( operandExpr );
+			v.value<NifExpr>().writeTree( ds );
+			break;
+		} // fall through
+	default:
+		ds << quint8( operandString ) << v.toString();
+		break;
+	}
+}
+
+void NifExpr::readOperand( QDataStream & ds, QVariant & v )
+{
+	quint8 tag;
+	ds >> tag;
+
+	switch ( tag ) {
+	case operandString:
+		{
+			QString str;
+			ds >> str;
+			v.setValue( str );
+		}
+		break;
+	case operandInt:
+		{
+			qint32 i;
+			ds >> i;
+			v.setValue( i );
+		}
+		break;
+	case operandUInt:
+		{
+			quint32 u;
+			ds >> u;
+			v.setValue( u );
+		}
+		break;
+	case operandExpr:
+		{
+			NifExpr e;
+			e.readTree( ds );
+			v = QVariant::fromValue( e );
+		}
+		break;
+	default:
+		v = QVariant();
+		break;
+	}
+}
+
+QDataStream & operator<<( QDataStream & ds, const NifExpr & e )
+{
+	e.writeTree( ds );
+	return ds;
+}
+
+QDataStream & operator>>( QDataStream & ds, NifExpr & e )
+{
+	e.readTree( ds );
+	e.compile();
+	return ds;
+}
+
+//! Appends the identifiers among an operand of a NifExpr
+static void appendIdentifiers( const QVariant & v, QStringList & names )
+{
+	if ( v.type() == QVariant::String ) {
+		if ( !names.contains( v.toString() ) )
+			names.append( v.toString() );
+	} else if ( v.type() == QVariant::UserType && v.canConvert<NifExpr>() ) {
+		for ( const QString & name : v.value<NifExpr>().identifiers() ) {
+			if ( !names.contains( name ) )
+				names.append( name );
+		}
+	}
+}
+
+QStringList NifExpr::identifiers() const
+{
+	QStringList names;
+	appendIdentifiers( lhs, names );
+	appendIdentifiers( rhs, names );
+	return names;
+}
+
 QString NifExpr::toString() const
 {
 	QString l = lhs.toString();
@@ -34,24 +34,64 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define NIFEXPR_H
 #pragma once
 
+#include "data/niffield.h"
+
+#include <QDataStream>
 #include <QRegularExpression>
 #include <QString>
+#include <QStringList>
 #include <QVariant>
+#include <QVector>
 
 
 //! @file nifexpr.h NifExpr
 
 class NifExpr final
 {
+	friend QDataStream & operator<<( QDataStream & ds, const NifExpr & e );
+	friend QDataStream & operator>>( QDataStream & ds, NifExpr & e );
+
+public:
+	//! An identifier referenced by a compiled expression
+	struct Symbol
+	{
+		//! The identifier as written in the XML
+		QString name;
+		//! The identifier is "ARG" and resolves through the argument of the parent
+		bool isArg = false;
+		//! The interned identifier; invalid for "ARG" and paths
+		NifFieldId field;
+	};
+
+private:
 	enum Operator
 	{
 		e_nop, e_not_eq, e_eq, e_gte, e_lte, e_gt, e_lt, e_bit_and, e_bit_or,
 		e_add, e_sub, e_div, e_mul, e_bool_and, e_bool_or, e_not,
+		// Only used by the compiled program
+		e_const, e_symbol,
 	};
+
+	//! One instruction of the compiled program
+	struct Instruction
+	{
+		Operator op;
+		//! Literal for e_const, index into symbols for e_symbol
+		quint32 arg;
+	};
+
+	//! Maximum stack depth of a compiled program
+	static const int MaxStack = 16;
+
 	QVariant lhs;
 	QVariant rhs;
 	Operator opcode;
 
+	//! Postfix program evaluated on a stack of quint32, empty if the expression could not be compiled
+	QVector<Instruction> program;
+	//! Identifiers referenced by the program
+	QVector<Symbol> symbols;
+
 public:
 	explicit NifExpr()
 	{
@@ -62,17 +102,107 @@ public:
 	{
 		opcode = NifExpr::e_nop;
 		partition( cond.mid( startpos, endpos - startpos + 1 ) );
+		compile();
 	}
 
 	NifExpr( const QString & cond )
 	{
 		opcode = NifExpr::e_nop;
 		partition( cond );
+		compile();
 	}
 
 	QString toString() const;
 
+	//! The identifiers the expression reads, whether or not it could be compiled
+	QStringList identifiers() const;
+
+	//! Whether the expression was compiled to integer bytecode
+	inline bool isCompiled() const { return !program.isEmpty(); }
+
+	//! The identifiers referenced by the compiled program
+	inline const QVector<Symbol> & compiledSymbols() const { return symbols; }
+
 public:
+	/*! Evaluates the compiled program.
+	 *
+	 * @param resolve	Functor returning the quint32 value of a Symbol
+	 */
+	template <class F>
+	quint32 evaluateCompiled( const F & resolve ) const
+	{
+		quint32 stack[MaxStack];
+		int sp = 0;
+
+		for ( const Instruction & ins : program ) {
+			switch ( ins.op ) {
+			case NifExpr::e_const:
+				stack[sp++] = ins.arg;
+				continue;
+			case NifExpr::e_symbol:
+				stack[sp++] = resolve( symbols.at( ins.arg ) );
+				continue;
+			case NifExpr::e_not:
+				stack[sp - 1] = !stack[sp - 1];
+				continue;
+			default:
+				break;
+			}
+
+			quint32 r = stack[--sp];
+			quint32 & l = stack[sp - 1];
+
+			switch ( ins.op ) {
+			case NifExpr::e_not_eq:
+				l = ( l != r );
+				break;
+			case NifExpr::e_eq:
+				l = ( l == r );
+				break;
+			case NifExpr::e_gte:
+				l = ( l >= r );
+				break;
+			case NifExpr::e_lte:
+				l = ( l <= r );
+				break;
+			case NifExpr::e_gt:
+				l = ( l > r );
+				break;
+			case NifExpr::e_lt:
+				l = ( l < r );
+				break;
+			case NifExpr::e_bit_and:
+				l = l & r;
+				break;
+			case NifExpr::e_bit_or:
+				l = l | r;
+				break;
+			case NifExpr::e_add:
+				l = l + r;
+				break;
+			case NifExpr::e_sub:
+				l = l - r;
+				break;
+			case NifExpr::e_div:
+				l = r ? l / r : 0;
+				break;
+			case NifExpr::e_mul:
+				l = l * r;
+				break;
+			case NifExpr::e_bool_and:
+				l = ( l && r );
+				break;
+			case NifExpr::e_bool_or:
+				l = ( l || r );
+				break;
+			default:
+				break;
+			}
+		}
+
+		return sp ? stack[0] : 0;
+	}
+
 	template <class F>
 	QVariant evaluateValue( const F & convert ) const
 	{
@@ -118,21 +248,52 @@ public:
 		return l;
 	}
 
+	/*! Evaluates the expression as a bool.
+	 *
+	 * Uses the compiled program when available, in which case the functor must also
+	 * accept a Symbol. The QVariant tree is only walked as a fallback.
+	 */
 	template <class F>
 	bool evaluateBool( const F & convert ) const
 	{
+		if ( isCompiled() )
+			return evaluateCompiled( convert ) != 0;
+
 		return evaluateValue( convert ).toBool();
 	}
 
+	//! Evaluates the expression as an integer. @see evaluateBool
 	template <class F>
 	int evaluateUInt( const F & convert ) const
 	{
+		if ( isCompiled() )
+			return evaluateCompiled( convert );
+
 		return evaluateValue( convert ).toUInt();
 	}
 
 private:
+	//! Tag for nested expressions built by partition(), which are never compiled on their own
+	struct Nested {};
+
+	NifExpr( const QString & cond, Nested )
+	{
+		opcode = NifExpr::e_nop;
+		partition( cond );
+	}
+
 	static Operator operatorFromString( const QString & str );
 	void partition( const QString & cond, int offset = 0 );
+	//! Writes the partitioned tree, without the compiled program
+	void writeTree( QDataStream & ds ) const;
+	//! Reads a tree written by writeTree()
+	void readTree( QDataStream & ds );
+	static void writeOperand( QDataStream & ds, const QVariant & v );
+	static void readOperand( QDataStream & ds, QVariant & v );
+	//! Compiles the partitioned tree to a postfix program
+	void compile();
+	bool compileExpr( const NifExpr & e, int & depth, int & maxDepth );
+	bool compileValue( const QVariant & v, int & depth, int & maxDepth );
 	void NormalizeVariants( QVariant & l, QVariant & r ) const;
 
 	template <class F>
@@ -149,4 +310,9 @@ private:
 
 Q_DECLARE_METATYPE( NifExpr )
 
+//! Writes a partitioned expression, e.g. to the schema cache
+QDataStream & operator<<( QDataStream & ds, const NifExpr & e );
+//! Reads a partitioned expression and compiles it
+QDataStream & operator>>( QDataStream & ds, NifExpr & e );
+
 #endif
@@ -33,8 +33,10 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "message.h"
 #include "data/niftypes.h"
 #include "model/nifmodel.h"
+#include "xml/schemacache.h"
 
 #include <QtXml> // QXmlDefaultHandler Inherited
+#include <QBuffer>
 #include <QCoreApplication>
 #include <QMessageBox>
 
@@ -50,6 +52,8 @@ QHash<QString, NifBlockPtr> NifModel::compounds;
 QHash<QString, NifBlockPtr> NifModel::fixedCompounds;
 QHash<QString, NifBlockPtr> NifModel::blocks;
 QMap<quint32, NifBlockPtr> NifModel::blockHashes;
+QVector<NifExpr>           NifModel::versionConditions;
+QSet<int>                  NifModel::versionConditionFields;
 
 //! Parses nif.xml
 class NifXmlHandler final : public QXmlDefaultHandler
@@ -578,9 +582,148 @@ public:
 			}
 		}
 
+		buildFieldTables();
+
 		return true;
 	}
 
+	//! Builds the row tables of all compounds and blocks for name lookups
+	static void buildFieldTables()
+	{
+		indexVersionConditions();
+
+		for ( NifBlockPtr c : NifModel::compounds )
+			buildFieldRows( c, false );
+
+		for ( NifBlockPtr b : NifModel::blocks )
+			buildFieldRows( b, true );
+
+		for ( NifBlockPtr c : NifModel::compounds )
+			linkFieldRows( c );
+
+		for ( NifBlockPtr b : NifModel::blocks ) {
+			linkFieldRows( b );
+
+			b->data = NifData( b->id, "NiBlock", b->text );
+			b->data.setFieldRows( b->fieldRows );
+		}
+
+		// Every name of the schema is interned by now
+		NifFieldId::freeze();
+	}
+
+	//! Numbers the distinct version conditions, so that a model can evaluate each once per header
+	static void indexVersionConditions()
+	{
+		NifModel::versionConditions.clear();
+		NifModel::versionConditionFields.clear();
+
+		QHash<QString, int> ids;
+		auto index = [&ids]( NifData & d ) {
+			if ( d.vercond().isEmpty() )
+				return;
+
+			int id = ids.value( d.vercond(), -1 );
+			if ( id < 0 ) {
+				id = NifModel::versionConditions.count();
+				ids.insert( d.vercond(), id );
+				NifModel::versionConditions.append( d.verexpr() );
+
+				// Paths into the header are matched by their last field
+				for ( const QString & name : d.verexpr().identifiers() )
+					NifModel::versionConditionFields.insert( NifFieldId( name.section( '\\', -1 ) ).value() );
+			}
+
+			d.setVercondId( id );
+		};
+
+		for ( NifBlockPtr c : NifModel::compounds ) {
+			for ( NifData & d : c->types )
+				index( d );
+		}
+
+		for ( NifBlockPtr b : NifModel::blocks ) {
+			for ( NifData & d : b->types )
+				index( d );
+		}
+	}
+
+	//! Appends the data of the rows of an instance of a type, in the order NifModel::insertType creates them
+	static void appendFieldRows( const NifBlockPtr & type, QVector<const NifData *> & rows, bool ancestors )
+	{
+		if ( ancestors && !type->ancestor.isEmpty() ) {
+			NifBlockPtr ancestor = NifModel::blocks.value( type->ancestor );
+			if ( ancestor )
+				appendFieldRows( ancestor, rows, true );
+		}
+
+		for ( const NifData & d : type->types ) {
+			if ( d.isArray() ) {
+				rows.append( &d );
+			} else if ( d.isCompound() ) {
+				// Unknown compounds are skipped by insertType
+				if ( NifModel::compounds.contains( d.type() ) )
+					rows.append( &d );
+			} else if ( d.isMixin() ) {
+				// Mixin rows belong to the parent
+				NifBlockPtr mixin = NifModel::compounds.value( d.type() );
+				if ( mixin )
+					appendFieldRows( mixin, rows, false );
+			} else {
+				rows.append( &d );
+			}
+		}
+	}
+
+	//! Builds the row table of a compound or block
+	static void buildFieldRows( const NifBlockPtr & type, bool ancestors )
+	{
+		QVector<const NifData *> rows;
+		appendFieldRows( type, rows, ancestors );
+
+		auto table = std::make_shared<NifFieldRows>();
+		table->count = rows.count();
+		for ( int r = 0; r < rows.count(); r++ )
+			table->rows[rows.at( r )->nameId().value()].append( r );
+
+		// Link each field to the rows whose condition or argument reads it as a sibling;
+		//	array lengths are left out, as arrays are resized by NifModel::updateArray
+		auto link = [&table]( QHash<int, QVector<int>> & links, const QStringList & names, int r ) {
+			for ( const QString & name : names ) {
+				NifFieldId field = NifFieldId::find( name );
+				if ( !field.isValid() || !table->rows.contains( field.value() ) )
+					continue;
+
+				QVector<int> & dependents = links[field.value()];
+				if ( !dependents.contains( r ) )
+					dependents.append( r );
+			}
+		};
+
+		for ( int r = 0; r < rows.count(); r++ ) {
+			const NifData * d = rows.at( r );
+
+			link( table->dependents, d->condexpr().identifiers(), r );
+			if ( !d->arg().isEmpty() )
+				link( table->argDependents, NifExpr( d->arg() ).identifiers(), r );
+		}
+
+		type->fieldRows = table;
+	}
+
+	//! Attaches the row tables of the compound types to the data of a compound or block
+	static void linkFieldRows( const NifBlockPtr & type )
+	{
+		for ( NifData & d : type->types ) {
+			if ( !d.isCompound() )
+				continue;
+
+			NifBlockPtr compound = NifModel::compounds.value( d.type() );
+			if ( compound )
+				d.setFieldRows( compound->fieldRows );
+		}
+	}
+
 	//! Reimplemented from QXmlContentHandler
 	QString errorString() const override final
 	{
@@ -630,10 +773,14 @@ QString NifModel::parseXmlDescription( const QString & filename )
 	QWriteLocker lck( &XMLlock );
 
 	compounds.clear();
+	fixedCompounds.clear();
 	blocks.clear();
+	blockHashes.clear();
 
 	supportedVersions.clear();
 
+	clearDerivedData();
+
 	NifValue::initialize();
 
 	QFile f( filename );
@@ -644,19 +791,94 @@ QString NifModel::parseXmlDescription( const QString & filename )
 	if ( !f.open( QIODevice::ReadOnly | QIODevice::Text ) )
 		return tr( "Couldn't open NIF XML description file: %1" ).arg( filename );
 
+	QByteArray xml = f.readAll();
+
+	// Skip parsing when the tables of this XML were cached before
+	SchemaCache cache( QFileInfo( filename ).fileName(), xml );
+	if ( QDataStream * ds = cache.read() ) {
+		if ( readSchema( *ds ) )
+			return QString();
+
+		compounds.clear();
+		fixedCompounds.clear();
+		blocks.clear();
+		blockHashes.clear();
+		supportedVersions.clear();
+		NifValue::initialize();
+	}
+
+	QBuffer buf( &xml );
+	buf.open( QIODevice::ReadOnly );
+
 	NifXmlHandler handler;
 	QXmlSimpleReader reader;
 	reader.setContentHandler( &handler );
 	reader.setErrorHandler( &handler );
-	QXmlInputSource source( &f );
+	QXmlInputSource source( &buf );
 	reader.parse( source );
 
 	if ( !handler.errorString().isEmpty() ) {
 		compounds.clear();
 		blocks.clear();
 		supportedVersions.clear();
+	} else {
+		writeSchema( *cache.write() );
+		cache.commit();
 	}
 
 	return handler.errorString();
 }
 
+// documented in nifmodel.h
+bool NifModel::readSchema( QDataStream & ds )
+{
+	quint32 count;
+
+	ds >> supportedVersions;
+	NifValue::readTypeTables( ds );
+
+	ds >> count;
+	for ( quint32 i = 0; i < count && ds.status() == QDataStream::Ok; i++ ) {
+		NifBlockPtr c( new NifBlock );
+		bool fixed;
+		ds >> *c >> fixed;
+
+		compounds.insert( c->id, c );
+		if ( fixed )
+			fixedCompounds.insert( c->id, c );
+	}
+
+	ds >> count;
+	for ( quint32 i = 0; i < count && ds.status() == QDataStream::Ok; i++ ) {
+		NifBlockPtr b( new NifBlock );
+		bool fixed;
+		ds >> *b >> fixed;
+
+		blocks.insert( b->id, b );
+		blockHashes.insert( DJB1Hash( b->id.toStdString().c_str() ), b );
+		if ( fixed )
+			fixedCompounds.insert( b->id, b );
+	}
+
+	if ( ds.status() != QDataStream::Ok || !ds.atEnd() )
+		return false;
+
+	NifXmlHandler::buildFieldTables();
+	return true;
+}
+
+// documented in nifmodel.h
+void NifModel::writeSchema( QDataStream & ds )
+{
+	ds << supportedVersions;
+	NifValue::writeTypeTables( ds );
+
+	ds << quint32( compounds.count() );
+	for ( NifBlockPtr c : compounds )
+		ds << *c << fixedCompounds.contains( c->id );
+
+	ds << quint32( blocks.count() );
+	for ( NifBlockPtr b : blocks )
+		ds << *b << fixedCompounds.contains( b->id );
+}
+
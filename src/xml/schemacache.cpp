@@ -0,0 +1,147 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#include "schemacache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+
+//! @file schemacache.cpp SchemaCache, NifData and NifBlock serialization
+
+//! Marks a schema cache file
+static const quint32 SchemaMagic = 0x4E534B43; // "NSKC"
+
+//! Version of the QDataStream encoding of the cache
+static const int SchemaStreamVersion = QDataStream::Qt_5_7;
+
+SchemaCache::SchemaCache( const QString & name, const QByteArray & xml )
+{
+	QString dir = QStandardPaths::writableLocation( QStandardPaths::CacheLocation );
+	if ( !dir.isEmpty() )
+		fileName = QDir( dir ).filePath( name + ".cache" );
+
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+	hash.addData( xml );
+	hash.addData( QByteArray::number( Version ) );
+	hash.addData( QByteArray( NIFSKOPE_VERSION ) );
+	key = hash.result();
+}
+
+QDataStream * SchemaCache::read()
+{
+	QFile f( fileName );
+	if ( fileName.isEmpty() || !f.open( QIODevice::ReadOnly ) )
+		return nullptr;
+
+	data = f.readAll();
+	stream.reset( new QDataStream( data ) );
+	stream->setVersion( SchemaStreamVersion );
+
+	quint32 magic = 0;
+	QByteArray k;
+	*stream >> magic >> k;
+
+	if ( stream->status() != QDataStream::Ok || magic != SchemaMagic || k != key )
+		return nullptr;
+
+	return stream.get();
+}
+
+QDataStream * SchemaCache::write()
+{
+	data.clear();
+	stream.reset( new QDataStream( &data, QIODevice::WriteOnly ) );
+	stream->setVersion( SchemaStreamVersion );
+	*stream << SchemaMagic << key;
+
+	return stream.get();
+}
+
+bool SchemaCache::commit()
+{
+	if ( fileName.isEmpty() || !stream || stream->status() != QDataStream::Ok )
+		return false;
+
+	QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+
+	QSaveFile f( fileName );
+	if ( !f.open( QIODevice::WriteOnly ) || f.write( data ) != data.size() )
+		return false;
+
+	return f.commit();
+}
+
+QDataStream & operator<<( QDataStream & ds, const NifData & data )
+{
+	const NifSharedData * d = data.d.constData();
+
+	ds << d->name << d->type << d->temp << d->arg << d->arr1 << d->arr2 << d->cond
+		<< d->ver1 << d->ver2 << d->text << d->vercond << quint32( d->flags )
+		<< d->condexpr << d->arr1expr << d->verexpr << data.value;
+
+	return ds;
+}
+
+QDataStream & operator>>( QDataStream & ds, NifData & data )
+{
+	NifSharedData * d = data.d.data();
+	quint32 flags;
+
+	ds >> d->name >> d->type >> d->temp >> d->arg >> d->arr1 >> d->arr2 >> d->cond
+		>> d->ver1 >> d->ver2 >> d->text >> d->vercond >> flags
+		>> d->condexpr >> d->arr1expr >> d->verexpr >> data.value;
+
+	for ( QString * str : { &d->name, &d->type, &d->temp, &d->arg, &d->arr1, &d->arr2, &d->cond, &d->vercond } )
+		*str = NifSharedData::pooled( *str );
+
+	d->nameId = NifFieldId( d->name );
+	d->flags = NifSharedData::DataFlags( flags );
+
+	return ds;
+}
+
+QDataStream & operator<<( QDataStream & ds, const NifBlock & block )
+{
+	ds << block.id << block.ancestor << block.text << block.abstract << block.types;
+	return ds;
+}
+
+QDataStream & operator>>( QDataStream & ds, NifBlock & block )
+{
+	ds >> block.id >> block.ancestor >> block.text >> block.abstract >> block.types;
+	return ds;
+}
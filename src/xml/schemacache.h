@@ -0,0 +1,88 @@
+/***** BEGIN LICENSE BLOCK *****
+
+BSD License
+
+Copyright (c) 2005-2015, NIF File Format Library and Tools
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. The name of the NIF File Format Library and Tools project may not be
+   used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+***** END LICENCE BLOCK *****/
+
+#ifndef SCHEMACACHE_H
+#define SCHEMACACHE_H
+
+#include "data/nifitem.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+
+#include <memory>
+
+
+//! @file schemacache.h SchemaCache
+
+/*! A compiled copy of the tables parsed from an XML description, keyed by a hash of the XML.
+ *
+ * NifModel and KfmModel write their tables here after parsing the XML, and read them back
+ * with a single file read for as long as the XML does not change.
+ */
+class SchemaCache final
+{
+public:
+	/*! Constructor
+	 *
+	 * @param name	The file name of the XML description
+	 * @param xml	The content of the XML description
+	 */
+	SchemaCache( const QString & name, const QByteArray & xml );
+
+	//! Get a stream over the cached tables, or nullptr if there are none for the XML
+	QDataStream * read();
+	//! Get a stream to write the tables to
+	QDataStream * write();
+	//! Save the tables written to the stream returned by write()
+	bool commit();
+
+	//! Format of the cache; bump whenever the layout of the tables or NifValue::Type change
+	static const quint32 Version = 1;
+
+private:
+	//! Path of the cache file
+	QString fileName;
+	//! Hash of the XML, format and application version
+	QByteArray key;
+	//! Content of the cache file after the key
+	QByteArray data;
+	//! Stream over data
+	std::unique_ptr<QDataStream> stream;
+};
+
+//! Writes a compound or block; the row table is left out and has to be rebuilt
+QDataStream & operator<<( QDataStream & ds, const NifBlock & block );
+//! Reads a compound or block
+QDataStream & operator>>( QDataStream & ds, NifBlock & block );
+
+#endif